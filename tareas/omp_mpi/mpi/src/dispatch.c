@@ -0,0 +1,255 @@
+// Copyright 2024 Josue Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+#include "plate.h"  // NOLINT
+
+// Tag of the messages a group sends to ask for a plate.
+#define TAG_REQUEST 1
+// Tag of the messages the dispatcher sends with the assigned plate.
+#define TAG_ASSIGN 2
+
+/**
+ * @brief Estimated cost of a plate, used to order and size the groups.
+ */
+typedef struct plate_cost {
+  double cost;     ///< Estimated work of the plate.
+  uint64_t index;  ///< Position of the plate in the job file.
+} PlateCost;
+
+/**
+ * @brief Estimates the cost of simulating a plate.
+ *
+ * @details Uses the number of cells, from the file header, and a rough
+ * estimate of the number of states: it grows with log(1 / epsilon) and
+ * shrinks with k = delta * alpha / (h * h), which sets how fast heat spreads.
+ * It is only used for scheduling, so it does not need to be accurate.
+ *
+ * @param params Parameters of the plate.
+ * @param dir Directory where the binary file is located.
+ * @return Estimated cost; 0 if the header could not be read.
+ */
+static double estimate_cost(const SimData* params, const char* dir) {
+  char file_path[512];
+  snprintf(file_path, sizeof(file_path), "%s/%s", dir, params->bin_name);
+  SharedData plate = {0};
+  FILE* bin_file = open_plate(file_path, &plate);
+  if (!bin_file) {
+    return 0.0;
+  }
+  fclose(bin_file);
+  double cost = (double) plate.rows * (double) plate.cols;
+  if (params->epsilon > 0.0 && params->epsilon < 1.0) {
+    cost *= 1.0 - log(params->epsilon);
+  }
+  const double k = (double) params->delta * params->alpha /
+    ((double) params->h * params->h);
+  if (k > 0.0) {
+    cost /= k;
+  }
+  return cost;
+}
+
+/**
+ * @brief Orders plates from the most to the least expensive.
+ *
+ * @details Plates with the same cost keep the job file order.
+ */
+static int compare_costs(const void* first, const void* second) {
+  const PlateCost* a = (const PlateCost*) first;
+  const PlateCost* b = (const PlateCost*) second;
+  if (a->cost != b->cost) {
+    return a->cost < b->cost ? 1 : -1;
+  }
+  return a->index < b->index ? -1 : a->index > b->index;
+}
+
+/**
+ * @brief Chooses how many workers simulate each plate.
+ *
+ * @details With groups of g workers, the job cannot end before the most
+ * expensive plate, which takes about max / g, nor before an even share of
+ * the whole job, total / workers. The smallest g for which the first bound
+ * does not exceed the second keeps the most groups, and so the least halo
+ * and reduction overhead per plate, without making the largest plate the
+ * bottleneck.
+ *
+ * @param costs Costs of the plates, from the most expensive.
+ * @param lines Number of plates.
+ * @param workers Number of processes that simulate plates.
+ * @return Number of processes per group, between 1 and workers.
+ */
+static int choose_group_size(const PlateCost* costs, uint64_t lines,
+  int workers) {
+  double total = 0.0;
+  for (uint64_t i = 0; i < lines; i++) {
+    total += costs[i].cost;
+  }
+  if (lines == 0 || total <= 0.0) {
+    return 1;
+  }
+  const double group_size = ceil(costs[0].cost * workers / total);
+  return group_size < 1.0 ? 1 :
+    group_size > workers ? workers : (int) group_size;
+}
+
+/**
+ * @brief Hands out plates to the groups until the job is done.
+ *
+ * @details Each group asks for a plate with the result of the previous one.
+ * Plates are handed out from the most to the least expensive, so long plates
+ * start first and small plates fill the gaps at the end. After a failure no
+ * more plates are handed out and the report is not written.
+ *
+ * @param dir Directory where the report will be written.
+ * @param sim_params Array of simulation parameter structures.
+ * @param lines Number of simulation entries to process.
+ * @param job_name Name of the job file for reporting.
+ * @param costs Plates from the most to the least expensive.
+ * @param groups Number of groups of workers.
+ */
+static void run_dispatcher(const char* dir, SimData* sim_params,
+  uint64_t lines, const char* job_name, const PlateCost* costs, int groups) {
+  uint64_t* sim_states_array = calloc(lines ? lines : 1, sizeof(uint64_t));
+  bool completed = sim_states_array != NULL;
+  if (!completed) {
+    fprintf(stderr, "Failed to allocate memory for simulation states.\n");
+  }
+
+  uint64_t next = 0;
+  int active = groups;
+  while (active > 0) {
+    // Result of the previous plate of the group: line, states and status.
+    uint64_t result[3];
+    MPI_Status status;
+    MPI_Recv(result, 3, MPI_UINT64_T, MPI_ANY_SOURCE, TAG_REQUEST,
+      MPI_COMM_WORLD, &status);
+    if (result[2] != EXIT_SUCCESS) {
+      completed = false;
+    } else if (result[0] < lines) {
+      sim_states_array[result[0]] = result[1];
+    }
+    // Line number `lines` tells the group to stop.
+    uint64_t line = lines;
+    if (completed && next < lines) {
+      line = costs[next++].index;
+    } else {
+      active--;
+    }
+    MPI_Send(&line, 1, MPI_UINT64_T, status.MPI_SOURCE, TAG_ASSIGN,
+      MPI_COMM_WORLD);
+  }
+
+  if (completed) {
+    create_report(dir, job_name, sim_params, sim_states_array, lines);
+  }
+  free(sim_states_array);
+}
+
+/**
+ * @brief Simulates the plates the dispatcher hands to the group.
+ *
+ * @details Rank 0 of the group talks to the dispatcher and broadcasts each
+ * assigned plate to the rest of the group, which simulates it together with
+ * simulate_plate().
+ *
+ * @param dir Directory containing the binary files.
+ * @param sim_params Array of simulation parameter structures.
+ * @param lines Number of simulation entries to process.
+ * @param group Processes of the group.
+ */
+static void run_worker(const char* dir, SimData* sim_params, uint64_t lines,
+  MPI_Comm group) {
+  int group_rank = -1;
+  MPI_Comm_rank(group, &group_rank);
+  SharedData* shared_data = calloc(1, sizeof(SharedData));
+  int error = shared_data ? EXIT_SUCCESS : EXIT_FAILURE;
+  int any_error = EXIT_SUCCESS;
+  MPI_Allreduce(&error, &any_error, 1, MPI_INT, MPI_MAX, group);
+  if (any_error != EXIT_SUCCESS && group_rank == 0) {
+    fprintf(stderr, "Failed to allocate memory for shared_data.\n");
+  }
+
+  // The first request carries no plate, only the status of the group.
+  uint64_t result[3] = {lines, 0, (uint64_t) any_error};
+  while (true) {
+    uint64_t line = lines;
+    if (group_rank == 0) {
+      MPI_Send(result, 3, MPI_UINT64_T, 0, TAG_REQUEST, MPI_COMM_WORLD);
+      MPI_Recv(&line, 1, MPI_UINT64_T, 0, TAG_ASSIGN, MPI_COMM_WORLD,
+        MPI_STATUS_IGNORE);
+    }
+    MPI_Bcast(&line, 1, MPI_UINT64_T, 0, group);
+    if (line >= lines) {
+      break;
+    }
+    result[0] = line;
+    result[2] = (uint64_t) simulate_plate(dir, &sim_params[line], shared_data,
+      group, &result[1]);
+  }
+  free(shared_data);
+}
+
+/**
+ * @brief Simulates the plates of a job on groups of processes on demand.
+ *
+ * @details Rank 0 becomes a dispatcher and the other processes are split
+ * with MPI_Comm_split into groups of equal size, chosen from the cost of the
+ * plates by choose_group_size(). Each group simulates a whole plate at a time
+ * and asks rank 0 for the next one when it finishes, so small plates do not
+ * pay the halo and reduction overhead of every process, and the job ends
+ * as early as possible. Rank 0 collects the state counts and writes the
+ * report. With fewer than two workers the dispatcher would only leave a
+ * process idle, so every plate is simulated by all the processes instead.
+ *
+ * @param dir Directory containing the binary files.
+ * @param sim_params Array of simulation parameter structures.
+ * @param lines Number of simulation entries to process.
+ * @param job_name Name of the job file for reporting.
+ * @param rank The MPI rank of the current process.
+ * @param size The total number of MPI processes.
+ */
+void dispatch_job(const char* dir, SimData* sim_params, uint64_t lines,
+  const char* job_name, int rank, int size) {
+  const int workers = size - 1;
+  if (workers < 2) {
+    read_plate(dir, sim_params, lines, job_name, rank);
+    return;
+  }
+
+  PlateCost* costs = NULL;
+  int group_size = 0;
+  if (rank == 0) {
+    costs = calloc(lines ? lines : 1, sizeof(PlateCost));
+    if (costs) {
+      for (uint64_t i = 0; i < lines; i++) {
+        costs[i].cost = estimate_cost(&sim_params[i], dir);
+        costs[i].index = i;
+      }
+      qsort(costs, lines, sizeof(PlateCost), compare_costs);
+      group_size = choose_group_size(costs, lines, workers);
+    } else {
+      fprintf(stderr, "Failed to allocate memory for the dispatcher.\n");
+    }
+  }
+  // Zero workers per group tells every process that rank 0 failed.
+  MPI_Bcast(&group_size, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  if (group_size == 0) {
+    return;
+  }
+
+  // Workers left over join the last group.
+  const int groups = workers / group_size;
+  int color = MPI_UNDEFINED;
+  if (rank > 0) {
+    color = (rank - 1) / group_size < groups ? (rank - 1) / group_size :
+      groups - 1;
+  }
+  MPI_Comm group;
+  MPI_Comm_split(MPI_COMM_WORLD, color, rank, &group);
+  if (rank == 0) {
+    run_dispatcher(dir, sim_params, lines, job_name, costs, groups);
+  } else {
+    run_worker(dir, sim_params, lines, group);
+    MPI_Comm_free(&group);
+  }
+  free(costs);
+}
@@ -5,11 +5,17 @@
 /**
  * @brief Main function for the MPI-based heat transfer simulation program.
  *
+ * @details Each process simulates its part of a plate with a team of OpenMP
+ * threads, as many as OMP_NUM_THREADS asks for, so a single process per node
+ * can use all of its cores.
+ *
  * @param argc Number of command-line arguments.
  * @param argv Array of command-line arguments.
  * argv[1]: Name of the job file (e.g., job001.txt).
  * argv[2]: Directory path where the job file is located (TSV and binary files
  * will be generated here as well).
+ * --dispatch: Optional, in any position. Rank 0 hands whole plates to groups
+ * of processes on demand instead of simulating each plate on all of them.
  * @return Returns 0 if execution is successful, or -1 if an error occurs.
  */
 int main(int argc, char *argv[]) {
@@ -18,18 +24,42 @@ int main(int argc, char *argv[]) {
   int rank = -1;
   total_start_time = MPI_Wtime();
 
-  if (MPI_Init(&argc, &argv) == MPI_SUCCESS) {
+  // Only the master thread of each process calls MPI.
+  int provided = MPI_THREAD_SINGLE;
+  if (MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided) ==
+    MPI_SUCCESS) {
     int size = -1;  // Total number of processes.
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
+    // Without funneled support, every process simulates with one thread.
+    if (provided < MPI_THREAD_FUNNELED) {
+      omp_set_num_threads(1);
+    }
+
+    // Select the simulation kernel for this CPU.
+    stencil_init();
+
+    // Remove the --dispatch option from the arguments, in any position.
+    bool dispatch = false;
+    for (int i = 1; i < argc; i++) {
+      if (strcmp(argv[i], "--dispatch") == 0) {
+        dispatch = true;
+        for (int j = i; j < argc - 1; j++) {
+          argv[j] = argv[j + 1];
+        }
+        argc--;
+        i--;
+      }
+    }
+
     // Ensure the necessary arguments are provided.
     if (argc < 3) {
       /**
        * @note The program can be compiled with (in case Makefile or other
        * compilation commands do not work):
        *
-       * mpicc -o heat_simulation main.c plate.c utils.c -lm
+       * mpicc -o heat_simulation *.c -lm
        * mpirun --oversubscribe -n 4 ./heat_simulation job001.txt ../test/job001/input  // NOLINT
        *
        * The "job" file can be replaced by the desired job number, as well as
@@ -37,7 +67,7 @@ int main(int argc, char *argv[]) {
        */
       fprintf(stderr, "Please run the program with: mpirun --oversubscribe -n "
         "<process_count> ./<executable file name> <job file name> "
-          "<input directory>\n");
+          "<input directory> [--dispatch]\n");
       MPI_Finalize();
       return -1;
     }
@@ -58,7 +88,11 @@ int main(int argc, char *argv[]) {
 
       // Process the simulation parameters using MPI.
       read_plate_start_time = MPI_Wtime();
-      read_plate(dir, sim_params, lines, job_name, rank, size);
+      if (dispatch) {
+        dispatch_job(dir, sim_params, lines, job_name, rank, size);
+      } else {
+        read_plate(dir, sim_params, lines, job_name, rank);
+      }
       read_plate_end_time = MPI_Wtime();
 
       // Free allocated memory for each SimData entry.
@@ -0,0 +1,50 @@
+// Copyright 2024 Josue Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+#include "matrix.h"  // NOLINT
+
+/**
+ * @brief Allocates a contiguous matrix aligned to cache lines.
+ *
+ * @details The width of every row is rounded up to a multiple of a cache
+ * line, so all rows start at the same offset relative to a line. Only the
+ * ghost columns are zeroed; plate columns stay uninitialized until they are
+ * read from the file.
+ *
+ * @param matrix Matrix to initialize.
+ * @param rows Number of plate rows.
+ * @param cols Number of plate columns.
+ * @return EXIT_SUCCESS if the memory was allocated, EXIT_FAILURE otherwise.
+ */
+int matrix_create(Matrix* matrix, uint64_t rows, uint64_t cols) {
+  matrix->rows = rows;
+  matrix->cols = cols;
+  matrix->stride = (MATRIX_LEAD + cols + 1 + CACHE_LINE_DOUBLES - 1) /
+    CACHE_LINE_DOUBLES * CACHE_LINE_DOUBLES;
+  matrix->buffer = (double*) aligned_alloc(CACHE_LINE_SIZE,
+    rows * matrix->stride * sizeof(double));
+  if (!matrix->buffer) {
+    matrix->data = NULL;
+    return EXIT_FAILURE;
+  }
+  matrix->data = matrix->buffer + MATRIX_LEAD;
+
+  // Clear the ghost columns of every row.
+  const uint64_t tail = matrix->stride - MATRIX_LEAD - cols;
+  for (uint64_t i = 0; i < rows; i++) {
+    double* row = matrix_row(matrix, i);
+    memset(row - MATRIX_LEAD, 0, MATRIX_LEAD * sizeof(double));
+    memset(row + cols, 0, tail * sizeof(double));
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Releases the memory block of the matrix.
+ *
+ * @param matrix Matrix to release.
+ */
+void matrix_destroy(Matrix* matrix) {
+  free(matrix->buffer);
+  matrix->buffer = NULL;
+  matrix->data = NULL;
+}
@@ -2,223 +2,537 @@
 
 #include "plate.h"  // NOLINT
 
+/**
+ * @brief Chooses the shape of the process grid for a plate.
+ *
+ * @details Among the grids that fit in the available processes, with no more
+ * grid rows than inner plate rows and no more grid columns than inner plate
+ * columns, it picks the one that uses the most processes and then the one
+ * with the fewest halo cells per step. Each grid row boundary costs a plate
+ * row and each grid column boundary costs a plate column, so long plates are
+ * cut across their long side. On ties, fewer grid columns win, since row
+ * halos are contiguous.
+ *
+ * @param rows Number of rows of the plate.
+ * @param cols Number of columns of the plate.
+ * @param size Number of processes available.
+ * @param dims Receives the number of grid rows and grid columns.
+ */
+static void choose_grid(uint64_t rows, uint64_t cols, int size, int dims[2]) {
+  const uint64_t inner_rows = rows > 2 ? rows - 2 : 1;
+  const uint64_t inner_cols = cols > 2 ? cols - 2 : 1;
+  uint64_t best_used = 0;
+  uint64_t best_cost = 0;
+  dims[0] = 1;
+  dims[1] = 1;
+  for (uint64_t grid_rows = 1; grid_rows <= (uint64_t) size &&
+    grid_rows <= inner_rows; grid_rows++) {
+    uint64_t grid_cols = (uint64_t) size / grid_rows;
+    if (grid_cols > inner_cols) {
+      grid_cols = inner_cols;
+    }
+    const uint64_t used = grid_rows * grid_cols;
+    const uint64_t cost = (grid_rows - 1) * inner_cols +
+      (grid_cols - 1) * inner_rows;
+    if (used > best_used || (used == best_used && (cost < best_cost ||
+      (cost == best_cost && grid_cols < (uint64_t) dims[1])))) {
+      best_used = used;
+      best_cost = cost;
+      dims[0] = (int) grid_rows;
+      dims[1] = (int) grid_cols;
+    }
+  }
+}
+
+/**
+ * @brief Splits the inner cells of one dimension between the grid.
+ *
+ * @param count Number of cells of the dimension, borders included.
+ * @param parts Number of grid positions along the dimension.
+ * @param index Grid position of this process.
+ * @param first Receives the first cell of the position.
+ * @param last Receives the cell after the last one of the position.
+ */
+void split_range(uint64_t count, int parts, int index, uint64_t* first,
+  uint64_t* last) {
+  const uint64_t inner = count > 2 ? count - 2 : 0;
+  *first = 1 + inner * index / parts;
+  *last = 1 + inner * (index + 1) / parts;
+}
+
+/**
+ * @brief Computes the cells of rows [first_row, last_row) and columns
+ * [first_col, last_col) of the next state of the plate.
+ *
+ * @details The kernel computes columns 1 to cols - 2 of the rows it gets, so
+ * the rows are passed starting one column before the range.
+ *
+ * @param shared_data Simulation parameters and matrices.
+ * @param first_row First row to compute.
+ * @param last_row Row after the last one to compute.
+ * @param first_col First column to compute.
+ * @param last_col Column after the last one to compute.
+ * @return true if every cell changed less than epsilon.
+ */
+static bool simulate_cells(SharedData* shared_data, uint64_t first_row,
+  uint64_t last_row, uint64_t first_col, uint64_t last_col) {
+  bool local_eq_point = true;
+  if (first_col >= last_col) {
+    return local_eq_point;
+  }
+  const uint64_t offset = first_col - 1;
+  const uint64_t width = last_col - first_col + 2;
+  for (uint64_t i = first_row; i < last_row; i++) {
+    const double* up = matrix_row(&shared_data->matrix, i - 1) + offset;
+    const double* row = matrix_row(&shared_data->matrix, i) + offset;
+    const double* down = matrix_row(&shared_data->matrix, i + 1) + offset;
+    double* next = matrix_row(&shared_data->temp_matrix, i) + offset;
+    // Compute the whole range with the vector kernel for this CPU.
+    double max_delta = stencil_row(up, row, down, next, width,
+      shared_data->alpha_delta);
+    if (max_delta >= shared_data->epsilon) {
+      local_eq_point = false;
+    }
+  }
+  return local_eq_point;
+}
+
+/**
+ * @brief Creates the persistent halo requests for one of the two matrices.
+ *
+ * @details The requests send the edge rows and columns of the block to the
+ * four neighbors and receive theirs into the halo around the block. Row
+ * halos are contiguous; column halos use the 'column' datatype, which picks
+ * one cell per row of the block. Halos sent up, down, left and right travel
+ * with tags 0, 1, 2 and 3. A missing neighbor is MPI_PROC_NULL, so its
+ * requests complete at once.
+ *
+ * @param matrix Matrix whose cells are exchanged.
+ * @param block Block of this process.
+ * @param column Datatype of one column of the block.
+ * @param neighbors Ranks above, below, left and right of the block.
+ * @param comm Communicator of the process grid.
+ * @param requests Receives the eight persistent requests.
+ */
+static void init_halo_requests(const Matrix* matrix, const Block* block,
+  MPI_Datatype column, const int neighbors[4], MPI_Comm comm,
+  MPI_Request* requests) {
+  const int width = (int) (block->last_col - block->first_col);
+  double* top = matrix_row(matrix, block->first_row) + block->first_col;
+  double* bottom = matrix_row(matrix, block->last_row - 1) + block->first_col;
+  double* left = matrix_row(matrix, block->first_row) + block->first_col;
+  double* right = matrix_row(matrix, block->first_row) + block->last_col - 1;
+  MPI_Recv_init(top - matrix->stride, width, MPI_DOUBLE, neighbors[0], 1,
+    comm, &requests[0]);
+  MPI_Recv_init(bottom + matrix->stride, width, MPI_DOUBLE, neighbors[1], 0,
+    comm, &requests[1]);
+  MPI_Recv_init(left - 1, 1, column, neighbors[2], 3, comm, &requests[2]);
+  MPI_Recv_init(right + 1, 1, column, neighbors[3], 2, comm, &requests[3]);
+  MPI_Send_init(top, width, MPI_DOUBLE, neighbors[0], 0, comm, &requests[4]);
+  MPI_Send_init(bottom, width, MPI_DOUBLE, neighbors[1], 1, comm,
+    &requests[5]);
+  MPI_Send_init(left, 1, column, neighbors[2], 2, comm, &requests[6]);
+  MPI_Send_init(right, 1, column, neighbors[3], 3, comm, &requests[7]);
+}
+
 /**
  * @brief Simulates heat transfer across a plate until equilibrium is reached.
  *
+ * @details Every process of the grid holds only its block and a one cell
+ * halo around it, in local coordinates. The block is computed by a team of
+ * OpenMP threads that lives for the whole simulation. Each step, the master
+ * thread, the only one that calls MPI, exchanges the halo of the current state
+ * with persistent requests while the other threads compute the cells that do
+ * not touch the halo. Once the halo arrives, all the threads compute the edge
+ * rows and columns of the block. With a single thread the halo travels in
+ * the background while that thread computes the inner cells. The matrices
+ * swap every step, so there is one set of requests per matrix.
+ *
+ * The equilibrium check of a step is started with MPI_Iallreduce and only
+ * completed at the end of the next step, so no step waits on a global
+ * reduction. The next step writes into the other matrix, which keeps the
+ * state of the checked step. When that state turns out to be the
+ * equilibrium, the extra step is dropped and the kept state is the result.
+ *
  * @param shared_data Pointer to a structure containing the simulation
- * parameters and matrices.
- * @param rank The MPI rank of the current process.
- * @param size The total number of MPI processes.
+ * parameters, the process grid and the local matrices.
  * @return The total number of simulation steps executed.
  */
-uint64_t simulate(SharedData* shared_data, int rank, int size) {
-  // Initialize the temporary matrix for pointer swapping.
-  for (uint64_t i = 0; i < shared_data->rows; i++) {
-    for (uint64_t j = 0; j < shared_data->cols; j++) {
-      shared_data->temp_matrix[i][j] = shared_data->matrix[i][j];
-    }
-  }
+uint64_t simulate(SharedData* shared_data) {
+  // Initialize the temporary matrix for pointer swapping. Both matrices share
+  // the same layout, so the whole block is copied at once.
+  memcpy(shared_data->temp_matrix.buffer, shared_data->matrix.buffer,
+    shared_data->matrix.rows * shared_data->matrix.stride * sizeof(double));
 
   uint64_t total_sim_states = 0;
-  bool global_eq_point = false;  // Global equilibrium flag.
-  bool local_eq_point;           // Local equilibrium flag.
-
-  // Broadcast shared parameters to all MPI processes.
-  MPI_Bcast(&shared_data->rows, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
-  MPI_Bcast(&shared_data->cols, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
-  MPI_Bcast(&shared_data->delta, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
-  MPI_Bcast(&shared_data->alpha, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
-  MPI_Bcast(&shared_data->h, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
-  MPI_Bcast(&shared_data->epsilon, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
-  MPI_Bcast(&shared_data->alpha_delta, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
-
-  // Determine the range of rows handled by each process.
-  uint64_t rows_per_process = (shared_data->rows - 2) / size;
-  uint64_t start_row = rank * rows_per_process + 1;
-  uint64_t final_row = (rank == size - 1) ? shared_data->rows - 1 : start_row +
-    rows_per_process;
-
-  while (!global_eq_point) {
-    total_sim_states++;
-    local_eq_point = true;
-
-    // Perform simulation step for the local rows.
-    for (uint64_t i = start_row; i < final_row; i++) {
-      for (uint64_t j = 1; j < shared_data->cols - 1; j++) {
-        double current_temperature = shared_data->matrix[i][j];
-        double surroundings_temperature = shared_data->matrix[i - 1][j] +
-          shared_data->matrix[i + 1][j] + shared_data->matrix[i][j - 1] +
-            shared_data->matrix[i][j + 1];
-        double new_temperature = current_temperature +
-          shared_data->alpha_delta * (surroundings_temperature - 4 *
-            current_temperature);
-        shared_data->temp_matrix[i][j] = new_temperature;
-
-        if (fabs(new_temperature - current_temperature) >=
-          shared_data->epsilon) {
-          local_eq_point = false;
+  bool local_eq_point = true;  // Local equilibrium flag.
+  bool local_eq = true, global_eq = false;  // Buffers of the reduction.
+  MPI_Request reduction = MPI_REQUEST_NULL;  // Check of the previous step.
+  bool done = false;  // Set by the master thread once equilibrium is found.
+
+  // The block starts at row 1 and column 1 of the local matrices.
+  const Block block = {
+    .first_row = 1,
+    .last_row = shared_data->matrix.rows - 1,
+    .first_col = 1,
+    .last_col = shared_data->matrix.cols - 1
+  };
+  int neighbors[4];
+  MPI_Cart_shift(shared_data->grid, 0, 1, &neighbors[0], &neighbors[1]);
+  MPI_Cart_shift(shared_data->grid, 1, 1, &neighbors[2], &neighbors[3]);
+
+  // One cell per row of the block, a row apart.
+  MPI_Datatype column;
+  MPI_Type_vector((int) (block.last_row - block.first_row), 1,
+    (int) shared_data->matrix.stride, MPI_DOUBLE, &column);
+  MPI_Type_commit(&column);
+  MPI_Request requests[2][8];
+  init_halo_requests(&shared_data->matrix, &block, column, neighbors,
+    shared_data->grid, requests[0]);
+  init_halo_requests(&shared_data->temp_matrix, &block, column, neighbors,
+    shared_data->grid, requests[1]);
+  int current = 0;  // Set of requests of the matrix holding the state.
+
+  const uint64_t first_row = block.first_row;
+  const uint64_t last_row = block.last_row;
+  const uint64_t first_col = block.first_col;
+  const uint64_t last_col = block.last_col;
+  // Number of edge rows of the block: none, one, or the top and the bottom.
+  const int edge_rows = last_row > first_row + 1 ? 2 :
+    last_row > first_row ? 1 : 0;
+  #pragma omp parallel default(shared)
+  {
+    const int thread_count = omp_get_num_threads();
+    // A lone thread has nobody to compute the inner cells while it waits.
+    const bool overlap = thread_count > 1;
+    while (!done) {
+      #pragma omp master
+      {
+        total_sim_states++;
+        // Exchange the edges of the current state.
+        MPI_Startall(8, requests[current]);
+        if (overlap) {
+          MPI_Waitall(8, requests[current], MPI_STATUSES_IGNORE);
         }
       }
-    }
 
-    // Exchange boundary rows with neighboring processes.
-    if (rank > 0) {
-      MPI_Send(shared_data->temp_matrix[start_row], shared_data->cols,
-        MPI_DOUBLE, rank - 1, 0, MPI_COMM_WORLD);
-      MPI_Recv(shared_data->temp_matrix[start_row - 1], shared_data->cols,
-        MPI_DOUBLE, rank - 1, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-    }
-    if (rank < size - 1) {
-      MPI_Send(shared_data->temp_matrix[final_row - 1], shared_data->cols,
-        MPI_DOUBLE, rank + 1, 0, MPI_COMM_WORLD);
-      MPI_Recv(shared_data->temp_matrix[final_row], shared_data->cols,
-        MPI_DOUBLE, rank + 1, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-    }
+      // Inner cells of the block only read cells of the block. The master
+      // thread joins once the halo has arrived.
+      #pragma omp for schedule(dynamic) nowait reduction(&&:local_eq_point)
+      for (uint64_t i = first_row + 1; i < last_row - 1; i++) {
+        local_eq_point &= simulate_cells(shared_data, i, i + 1,
+          first_col + 1, last_col - 1);
+      }
 
-    // Check for global equilibrium across all processes.
-    bool local_eq = local_eq_point;
-    bool global_eq;
-    MPI_Allreduce(&local_eq, &global_eq, 1, MPI_C_BOOL, MPI_LAND,
-      MPI_COMM_WORLD);
-    global_eq_point = global_eq;
+      #pragma omp master
+      if (!overlap) {
+        MPI_Waitall(8, requests[current], MPI_STATUSES_IGNORE);
+      }
+      // Edge rows and columns need the halo.
+      #pragma omp barrier
 
-    // Swap the matrices for the next iteration.
-    double** temp = shared_data->matrix;
-    shared_data->matrix = shared_data->temp_matrix;
-    shared_data->temp_matrix = temp;
+      // Each edge row is split in one piece of columns per thread.
+      #pragma omp for schedule(static) reduction(&&:local_eq_point)
+      for (int piece = 0; piece < edge_rows * thread_count; piece++) {
+        const uint64_t row = piece < thread_count ? first_row : last_row - 1;
+        uint64_t piece_first = 0, piece_last = 0;
+        split_range(last_col + 1, thread_count, piece % thread_count,
+          &piece_first, &piece_last);
+        local_eq_point &= simulate_cells(shared_data, row, row + 1,
+          piece_first, piece_last);
+      }
+      #pragma omp for schedule(static) reduction(&&:local_eq_point)
+      for (uint64_t i = first_row + 1; i < last_row - 1; i++) {
+        local_eq_point &= simulate_cells(shared_data, i, i + 1, first_col,
+          first_col + 1);
+        if (last_col > first_col + 1) {
+          local_eq_point &= simulate_cells(shared_data, i, i + 1,
+            last_col - 1, last_col);
+        }
+      }
+
+      #pragma omp master
+      {
+        // The check of the previous step had this whole step to complete.
+        // If it found the equilibrium, that state is still in the current
+        // matrix.
+        if (reduction != MPI_REQUEST_NULL) {
+          MPI_Wait(&reduction, MPI_STATUS_IGNORE);
+          if (global_eq) {
+            total_sim_states--;
+            done = true;
+          }
+        }
+        if (!done) {
+          // Check for global equilibrium across all processes in the
+          // background.
+          local_eq = local_eq_point;
+          MPI_Iallreduce(&local_eq, &global_eq, 1, MPI_C_BOOL, MPI_LAND,
+            shared_data->grid, &reduction);
+
+          // Swap the matrices for the next iteration.
+          Matrix temp = shared_data->matrix;
+          shared_data->matrix = shared_data->temp_matrix;
+          shared_data->temp_matrix = temp;
+          current = 1 - current;
+        }
+        local_eq_point = true;
+      }
+      #pragma omp barrier
+    }
   }
 
+  for (int i = 0; i < 8; i++) {
+    MPI_Request_free(&requests[0][i]);
+    MPI_Request_free(&requests[1][i]);
+  }
+  MPI_Type_free(&column);
   return total_sim_states;
 }
 
 /**
- * @brief Reads a binary plate file and initializes the simulation environment.
+ * @brief Creates the datatype that broadcasts the parameters of a plate.
  *
- * @param dir Directory containing the binary files.
- * @param sim_params Array of simulation parameter structures.
- * @param lines Number of simulation entries to process.
- * @param job_name Name of the job file for reporting.
- * @param rank The MPI rank of the current process.
- * @param size The total number of MPI processes.
+ * @details Covers the fields of SharedData from rows to alpha_delta: four
+ * 64-bit integers followed by three doubles.
+ *
+ * @return The committed datatype.
  */
-void read_plate(const char* dir, SimData* sim_params, uint64_t lines,
-  const char* job_name, int rank, int size) {
-  FILE *bin_file;
-  char file_path[512];
-  SharedData* shared_data = malloc(sizeof(SharedData));
-  if (!shared_data) {
-    fprintf(stderr, "Failed to allocate memory for shared_data.\n");
-    return;
+static MPI_Datatype create_params_type(void) {
+  const int lengths[2] = {4, 3};
+  const MPI_Aint displacements[2] = {
+    offsetof(SharedData, rows), offsetof(SharedData, alpha)
+  };
+  const MPI_Datatype types[2] = {MPI_UINT64_T, MPI_DOUBLE};
+  MPI_Datatype params_type;
+  MPI_Type_create_struct(2, lengths, displacements, types, &params_type);
+  MPI_Type_commit(&params_type);
+  return params_type;
+}
+
+/**
+ * @brief Opens a plate file and reads its dimensions.
+ *
+ * @details The size of the file must match the dimensions in its header, so
+ * a truncated plate is rejected before any data is distributed.
+ *
+ * @param file_path Path of the binary file.
+ * @param shared_data Receives the number of rows and columns.
+ * @return The open file, or NULL if it could not be read.
+ */
+FILE* open_plate(const char* file_path, SharedData* shared_data) {
+  FILE* bin_file = fopen(file_path, "rb");
+  if (!bin_file) {
+    return NULL;
+  }
+  uint64_t dims[2] = {0, 0};
+  bool valid = fread(dims, sizeof(uint64_t), 2, bin_file) == 2 &&
+    dims[0] > 0 && dims[1] > 0 && dims[1] <= UINT64_MAX / sizeof(double) /
+      dims[0] && fseek(bin_file, 0, SEEK_END) == 0;
+  if (valid) {
+    const long size = ftell(bin_file);
+    valid = size >= 0 && (uint64_t) size == 2 * sizeof(uint64_t) +
+      dims[0] * dims[1] * sizeof(double);
+  }
+  if (!valid) {
+    fclose(bin_file);
+    return NULL;
   }
+  shared_data->rows = dims[0];
+  shared_data->cols = dims[1];
+  return bin_file;
+}
 
-  uint64_t* sim_states_array = malloc(lines * sizeof(uint64_t));
-  if (!sim_states_array) {
-    fprintf(stderr, "Failed to allocate memory for simulation states.\n");
-    free(shared_data);
-    return;
+/**
+ * @brief Builds the process grid of a plate and allocates the local block.
+ *
+ * @details The grid is built with MPI_Cart_create and shaped after the plate
+ * by choose_grid(). Ranks are not reordered, so rank 0 of the communicator is
+ * always rank 0 of the grid. Every process of the grid allocates its block
+ * plus a one cell halo; processes left out of the grid allocate nothing.
+ *
+ * @param shared_data Simulation data of the plate.
+ * @param comm Processes that simulate the plate.
+ * @param rank The rank of the current process in comm.
+ * @param size The number of processes in comm.
+ * @return EXIT_SUCCESS if the local matrices were allocated.
+ */
+static int create_domain(SharedData* shared_data, MPI_Comm comm, int rank,
+  int size) {
+  choose_grid(shared_data->rows, shared_data->cols, size, shared_data->dims);
+  const int periods[2] = {0, 0};
+  MPI_Cart_create(comm, 2, shared_data->dims, periods, 0,
+    &shared_data->grid);
+  if (shared_data->grid == MPI_COMM_NULL) {
+    return EXIT_SUCCESS;
   }
 
-  for (uint64_t i = 0; i < lines; i++) {
-    snprintf(file_path, sizeof(file_path), "%s/%s", dir,
-      sim_params[i].bin_name);
-    bin_file = fopen(file_path, "rb");
+  // Without reordering, the rank in the grid is the rank in comm.
+  MPI_Cart_coords(shared_data->grid, rank, 2, shared_data->coords);
+  Block* block = &shared_data->block;
+  split_range(shared_data->rows, shared_data->dims[0], shared_data->coords[0],
+    &block->first_row, &block->last_row);
+  split_range(shared_data->cols, shared_data->dims[1], shared_data->coords[1],
+    &block->first_col, &block->last_col);
+  const uint64_t local_rows = block->last_row - block->first_row + 2;
+  const uint64_t local_cols = block->last_col - block->first_col + 2;
+  if (matrix_create(&shared_data->matrix, local_rows, local_cols) !=
+    EXIT_SUCCESS) {
+    return EXIT_FAILURE;
+  }
+  if (matrix_create(&shared_data->temp_matrix, local_rows, local_cols) !=
+    EXIT_SUCCESS) {
+    matrix_destroy(&shared_data->matrix);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Releases the process grid and the local matrices of a plate.
+ *
+ * @param shared_data Simulation data of the plate.
+ */
+static void destroy_domain(SharedData* shared_data) {
+  if (shared_data->grid != MPI_COMM_NULL) {
+    matrix_destroy(&shared_data->matrix);
+    matrix_destroy(&shared_data->temp_matrix);
+    MPI_Comm_free(&shared_data->grid);
+  }
+}
+
+/**
+ * @brief Simulates one plate on the processes of a communicator.
+ *
+ * @details Rank 0 of the communicator validates the header of the binary
+ * file and broadcasts the dimensions and parameters of the plate with a
+ * single derived datatype. Every process then reads only its block, with
+ * collective MPI-IO or through a scatter from rank 0 depending on
+ * MPI_PLATE_IO, and writes it back into the output file the same way.
+ *
+ * @param dir Directory containing the binary files.
+ * @param params Parameters of the plate.
+ * @param shared_data Simulation data, reused from plate to plate.
+ * @param comm Processes that simulate the plate.
+ * @param sim_states Receives the number of states on every process of comm;
+ * 0 if the plate data could not be read.
+ * @return EXIT_SUCCESS unless the plate could not be opened or its matrices
+ * could not be allocated, on every process of comm.
+ */
+int simulate_plate(const char* dir, const SimData* params,
+  SharedData* shared_data, MPI_Comm comm, uint64_t* sim_states) {
+  int rank = -1, size = -1;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+  char file_path[512];
+  snprintf(file_path, sizeof(file_path), "%s/%s", dir, params->bin_name);
+
+  // Rank 0 reads the header; zero rows tell the others it failed.
+  FILE* bin_file = NULL;
+  if (rank == 0) {
+    bin_file = open_plate(file_path, shared_data);
     if (!bin_file) {
-      fprintf(stderr, "Failed to open binary file: %s.\n",
-        sim_params[i].bin_name);
-      free(sim_states_array);
-      free(shared_data);
-      return;
+      fprintf(stderr, "Failed to open binary file: %s.\n", params->bin_name);
+      shared_data->rows = 0;
     }
+    shared_data->delta = params->delta;
+    shared_data->alpha = params->alpha;
+    shared_data->h = params->h;
+    shared_data->epsilon = params->epsilon;
+    shared_data->alpha_delta = params->delta * params->alpha /
+      (params->h * params->h);
+  }
+  MPI_Datatype params_type = create_params_type();
+  MPI_Bcast(shared_data, 1, params_type, 0, comm);
+  MPI_Type_free(&params_type);
+  if (shared_data->rows == 0) {
+    return EXIT_FAILURE;
+  }
 
-    fread(&shared_data->rows, sizeof(uint64_t), 1, bin_file);
-    fread(&shared_data->cols, sizeof(uint64_t), 1, bin_file);
-
-    shared_data->matrix = create_matrix(shared_data->rows, shared_data->cols);
-    shared_data->temp_matrix = create_matrix(shared_data->rows,
-      shared_data->cols);
-    if (!shared_data->matrix || !shared_data->temp_matrix) {
+  // Every process must have its block before any data moves.
+  int error = create_domain(shared_data, comm, rank, size);
+  int any_error = EXIT_SUCCESS;
+  MPI_Allreduce(&error, &any_error, 1, MPI_INT, MPI_MAX, comm);
+  if (any_error != EXIT_SUCCESS) {
+    if (rank == 0) {
       fprintf(stderr, "Failed to allocate memory for matrices.\n");
       fclose(bin_file);
-      free_matrix(shared_data->matrix, shared_data->rows);
-      free_matrix(shared_data->temp_matrix, shared_data->rows);
-      free(sim_states_array);
-      free(shared_data);
-      return;
     }
-
-    for (uint64_t i = 0; i < shared_data->rows; i++) {
-      if (fread(shared_data->matrix[i], sizeof(double), shared_data->cols,
-        bin_file) != shared_data->cols) {
-        fprintf(stderr, "Error reading matrix data from file: %s.\n",
-          sim_params[i].bin_name);
-        free_matrix(shared_data->matrix, shared_data->rows);
-        free_matrix(shared_data->temp_matrix, shared_data->rows);
-        fclose(bin_file);
-        free(sim_states_array);
-        free(shared_data);
-        return;
-      }
+    if (error == EXIT_SUCCESS) {
+      destroy_domain(shared_data);
+    } else if (shared_data->grid != MPI_COMM_NULL) {
+      MPI_Comm_free(&shared_data->grid);
     }
+    return EXIT_FAILURE;
+  }
 
-    shared_data->delta = sim_params[i].delta;
-    shared_data->alpha = sim_params[i].alpha;
-    shared_data->h = sim_params[i].h;
-    shared_data->epsilon = sim_params[i].epsilon;
-    shared_data->alpha_delta = sim_params[i].delta * sim_params[i].alpha /
-      (sim_params[i].h * sim_params[i].h);
-
-    sim_states_array[i] = simulate(shared_data, rank, size);
-    write_plate(shared_data->matrix, shared_data->rows, shared_data->cols, dir,
-      sim_params[i].bin_name, sim_states_array[i]);
+  *sim_states = 0;
+  if (shared_data->grid != MPI_COMM_NULL) {
+#if MPI_PLATE_IO
+    const int read_error = read_plate_blocks(file_path, shared_data);
+#else
+    const int read_error = scatter_plate(bin_file, shared_data, rank);
+#endif
+    if (read_error == EXIT_SUCCESS) {
+      *sim_states = simulate(shared_data);
+#if MPI_PLATE_IO
+      write_plate_blocks(shared_data, dir, params->bin_name, *sim_states,
+        rank);
+#else
+      gather_plate(bin_file, shared_data, dir, params->bin_name, *sim_states,
+        rank);
+#endif
+    } else if (rank == 0) {
+      fprintf(stderr, "Error reading matrix data from file: %s.\n",
+        params->bin_name);
+    }
+  }
+  // Processes outside the grid still report the state count.
+  MPI_Bcast(sim_states, 1, MPI_UINT64_T, 0, comm);
 
-    free_matrix(shared_data->matrix, shared_data->rows);
-    free_matrix(shared_data->temp_matrix, shared_data->rows);
+  destroy_domain(shared_data);
+  if (rank == 0) {
     fclose(bin_file);
   }
-
-  create_report(dir, job_name, sim_params, sim_states_array, lines);
-  free(sim_states_array);
-  free(shared_data);
+  return EXIT_SUCCESS;
 }
 
 /**
- * @brief Allocates memory for a matrix with the specified dimensions.
+ * @brief Reads the plates of a job, simulates them and writes the results.
  *
- * @param rows Number of rows in the matrix.
- * @param cols Number of columns in the matrix.
- * @return Pointer to the created matrix.
+ * @details Every plate is simulated by all the processes, one after another,
+ * with simulate_plate(). Rank 0 writes the report.
+ *
+ * @param dir Directory containing the binary files.
+ * @param sim_params Array of simulation parameter structures.
+ * @param lines Number of simulation entries to process.
+ * @param job_name Name of the job file for reporting.
+ * @param rank The MPI rank of the current process.
  */
-double** create_matrix(uint64_t rows, uint64_t cols) {
-  double** matrix = malloc(rows * sizeof(double*));
-  if (!matrix) {
-    fprintf(stderr, "Failed to allocate memory for matrix rows.\n");
-    return NULL;
+void read_plate(const char* dir, SimData* sim_params, uint64_t lines,
+  const char* job_name, int rank) {
+  SharedData* shared_data = calloc(1, sizeof(SharedData));
+  if (!shared_data) {
+    fprintf(stderr, "Failed to allocate memory for shared_data.\n");
+    return;
   }
 
-  for (uint64_t i = 0; i < rows; i++) {
-    matrix[i] = malloc(cols * sizeof(double));
-    if (!matrix[i]) {
-      fprintf(stderr, "Failed to allocate memory for matrix columns.\n");
-      for (uint64_t j = 0; j < i; j++) {
-        free(matrix[j]);
-      }
-      free(matrix);
-      return NULL;
-    }
+  uint64_t* sim_states_array = malloc(lines * sizeof(uint64_t));
+  if (!sim_states_array) {
+    fprintf(stderr, "Failed to allocate memory for simulation states.\n");
+    free(shared_data);
+    return;
   }
 
-  return matrix;
-}
+  bool completed = true;
+  for (uint64_t i = 0; i < lines && completed; i++) {
+    completed = simulate_plate(dir, &sim_params[i], shared_data,
+      MPI_COMM_WORLD, &sim_states_array[i]) == EXIT_SUCCESS;
+  }
 
-/**
- * @brief Frees the memory allocated for a matrix.
- *
- * @param matrix Pointer to the matrix to free.
- * @param rows Number of rows in the matrix.
- */
-void free_matrix(double** matrix, uint64_t rows) {
-  for (uint64_t i = 0; i < rows; i++) {
-    free(matrix[i]);
+  if (completed && rank == 0) {
+    create_report(dir, job_name, sim_params, sim_states_array, lines);
   }
-  free(matrix);
+  free(sim_states_array);
+  free(shared_data);
 }
@@ -6,13 +6,21 @@
 // Maximum allowed length for file paths.
 #define MAX_PATH_LENGTH 1024
 
+// Plates are read and written with collective MPI-IO; build with
+// DEFS="-DMPI_PLATE_IO=0" to move them through rank 0 instead.
+#ifndef MPI_PLATE_IO
+#define MPI_PLATE_IO 1
+#endif
+
 // For high-precision timing.
 #define _POSIX_C_SOURCE 199309L
 
 #include <mpi.h>
+#include <omp.h>
 #include <math.h>
 #include <time.h>
 #include <stdio.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -20,6 +28,9 @@
 #include <stdbool.h>
 #include <inttypes.h>
 
+#include "matrix.h"  // NOLINT
+#include "stencil.h"  // NOLINT
+
 // Structure to store simulation parameters for a specific plate.
 typedef struct simulation_parameters {
   uint64_t delta;  ///< Time interval for the simulation.
@@ -29,7 +40,16 @@ typedef struct simulation_parameters {
   char* bin_name;  ///< Name of the associated binary file.
 } SimData;
 
-// Structure to store shared data for simulation calculations.
+// Block of inner plate cells owned by a process in the process grid.
+typedef struct block {
+  uint64_t first_row;  ///< First plate row of the block.
+  uint64_t last_row;   ///< Plate row after the last one of the block.
+  uint64_t first_col;  ///< First plate column of the block.
+  uint64_t last_col;   ///< Plate column after the last one of the block.
+} Block;
+
+// Structure to store shared data for simulation calculations. The fields up
+// to alpha_delta are broadcast together with the PlateParams datatype.
 typedef struct shared_thread_data {
   uint64_t rows;         ///< Number of rows in the simulation plate.
   uint64_t cols;         ///< Number of columns in the simulation plate.
@@ -38,21 +58,36 @@ typedef struct shared_thread_data {
   double alpha;          ///< Coefficient for heat transfer calculations.
   double epsilon;        ///< Convergence tolerance for calculations.
   double alpha_delta;    ///< Combined parameter for optimized calculations.
-  double** matrix;       ///< Main plate matrix for the simulation.
-  double** temp_matrix;  ///< Temporary matrix for intermediate calculations.
+  MPI_Comm grid;         ///< Process grid; MPI_COMM_NULL if left out.
+  int dims[2];           ///< Grid rows and grid columns.
+  int coords[2];         ///< Position of this process in the grid.
+  Block block;           ///< Plate cells owned by this process.
+  Matrix matrix;         ///< Block and its halo, in local coordinates.
+  Matrix temp_matrix;    ///< Temporary matrix for intermediate calculations.
 } SharedData;
 
 // Functions declaration.
-uint64_t simulate(SharedData* shared_data, int rank, int size);
+void split_range(uint64_t count, int parts, int index, uint64_t* first,
+  uint64_t* last);
+uint64_t simulate(SharedData* shared_data);
+FILE* open_plate(const char* file_path, SharedData* shared_data);
+int simulate_plate(const char* dir, const SimData* params,
+  SharedData* shared_data, MPI_Comm comm, uint64_t* sim_states);
 void read_plate(const char* dir, SimData* sim_params, uint64_t lines,
+  const char* job_name, int rank);
+void dispatch_job(const char* dir, SimData* sim_params, uint64_t lines,
   const char* job_name, int rank, int size);
-double** create_matrix(uint64_t rows, uint64_t cols);
-void free_matrix(double** matrix, uint64_t rows);
 SimData* read_job_file(const char* job_name, const char* dir, uint64_t* lines);
 void create_report(const char* dir, const char* job_name, SimData* sim_params,
   uint64_t* sim_states, uint64_t lines);
-void write_plate(double** matrix, uint64_t rows, uint64_t cols,
-  const char* dir, const char* job_name, uint64_t sim_states);
+int scatter_plate(FILE* bin_file, SharedData* shared_data, int rank);
+int gather_plate(FILE* bin_file, const SharedData* shared_data, const char* dir,
+  const char* bin_name, uint64_t sim_states, int rank);
+int read_plate_blocks(const char* file_path, SharedData* shared_data);
+int write_plate_blocks(const SharedData* shared_data, const char* dir,
+  const char* bin_name, uint64_t sim_states, int rank);
+void plate_output_path(char* path, size_t capacity, const char* dir,
+  const char* bin_name, uint64_t sim_states);
 char* format_time(const time_t seconds, char* text, const size_t capacity);
 uint64_t count_job_lines(const char* bin_name);
 
@@ -0,0 +1,425 @@
+// Copyright 2024 Josue Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+#include "plate.h"  // NOLINT
+
+/**
+ * @brief Reads rows [first, last) of a plate file.
+ *
+ * @param bin_file Open plate file.
+ * @param cols Number of columns of the plate.
+ * @param first First row to read.
+ * @param last Row after the last one to read.
+ * @param rows Buffer that receives the rows, without padding.
+ * @return EXIT_SUCCESS if every row was read, EXIT_FAILURE otherwise.
+ */
+static int read_rows(FILE* bin_file, uint64_t cols, uint64_t first,
+  uint64_t last, double* rows) {
+  const uint64_t count = (last - first) * cols;
+  const long offset = (long) (2 * sizeof(uint64_t) +
+    first * cols * sizeof(double));
+  if (fseek(bin_file, offset, SEEK_SET) != 0 ||
+    fread(rows, sizeof(double), count, bin_file) != count) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Returns the largest number of rows of a band of the process grid.
+ *
+ * @param shared_data Simulation data with the process grid.
+ * @return Rows of the tallest band, without halo rows.
+ */
+static uint64_t max_band_rows(const SharedData* shared_data) {
+  uint64_t max_rows = 0;
+  for (int band = 0; band < shared_data->dims[0]; band++) {
+    uint64_t first = 0, last = 0;
+    split_range(shared_data->rows, shared_data->dims[0], band, &first, &last);
+    if (last - first > max_rows) {
+      max_rows = last - first;
+    }
+  }
+  return max_rows;
+}
+
+/**
+ * @brief Distributes a plate so that every process gets only its block.
+ *
+ * @details Rank 0 reads the plate one band of grid rows at a time, with the
+ * halo rows above and below the band. It packs the block of every process of
+ * the band, with its halo, one after another and sends them with
+ * MPI_Scatterv. Each process receives its block straight into its local
+ * matrix through a vector datatype. Rank 0 never holds more than one band.
+ *
+ * @param bin_file Plate file, open on rank 0 only.
+ * @param shared_data Simulation data with the process grid and the local
+ * matrices.
+ * @param rank The MPI rank of the current process.
+ * @return EXIT_SUCCESS if the plate was read, EXIT_FAILURE otherwise, on
+ * every process of the grid.
+ */
+int scatter_plate(FILE* bin_file, SharedData* shared_data, int rank) {
+  const uint64_t cols = shared_data->cols;
+  const int* dims = shared_data->dims;
+  int grid_size = 0;
+  MPI_Comm_size(shared_data->grid, &grid_size);
+
+  // The local matrix, halo included, is the receive buffer.
+  MPI_Datatype local;
+  MPI_Type_vector((int) shared_data->matrix.rows,
+    (int) shared_data->matrix.cols, (int) shared_data->matrix.stride,
+    MPI_DOUBLE, &local);
+  MPI_Type_commit(&local);
+
+  int error = EXIT_SUCCESS;
+  double* band = NULL;
+  double* packed = NULL;
+  int* counts = NULL;
+  int* displs = NULL;
+  if (rank == 0) {
+    const uint64_t band_rows = max_band_rows(shared_data) + 2;
+    band = malloc(band_rows * cols * sizeof(double));
+    packed = malloc(band_rows * (cols + 2 * dims[1]) * sizeof(double));
+    counts = calloc(grid_size, sizeof(int));
+    displs = calloc(grid_size, sizeof(int));
+    if (!band || !packed || !counts || !displs) {
+      error = EXIT_FAILURE;
+    }
+  }
+  // Every process must agree on whether the bands are sent.
+  MPI_Bcast(&error, 1, MPI_INT, 0, shared_data->grid);
+  const bool ready = error == EXIT_SUCCESS;
+
+  for (int band_index = 0; ready && band_index < dims[0]; band_index++) {
+    uint64_t first = 0, last = 0;
+    split_range(shared_data->rows, dims[0], band_index, &first, &last);
+    const uint64_t band_rows = last - first + 2;
+    if (rank == 0) {
+      if (read_rows(bin_file, cols, first - 1, last + 1, band) !=
+        EXIT_SUCCESS) {
+        error = EXIT_FAILURE;
+        memset(band, 0, band_rows * cols * sizeof(double));
+      }
+      // Pack the blocks of the band, each with its halo.
+      memset(counts, 0, grid_size * sizeof(int));
+      uint64_t offset = 0;
+      for (int col_index = 0; col_index < dims[1]; col_index++) {
+        const int coords[2] = {band_index, col_index};
+        int destination = 0;
+        MPI_Cart_rank(shared_data->grid, coords, &destination);
+        uint64_t first_col = 0, last_col = 0;
+        split_range(cols, dims[1], col_index, &first_col, &last_col);
+        const uint64_t width = last_col - first_col + 2;
+        for (uint64_t i = 0; i < band_rows; i++) {
+          memcpy(packed + offset + i * width, band + i * cols + first_col - 1,
+            width * sizeof(double));
+        }
+        counts[destination] = (int) (band_rows * width);
+        displs[destination] = (int) offset;
+        offset += band_rows * width;
+      }
+    }
+    const int receive = shared_data->coords[0] == band_index ? 1 : 0;
+    MPI_Scatterv(packed, counts, displs, MPI_DOUBLE,
+      matrix_row(&shared_data->matrix, 0), receive, local, 0,
+      shared_data->grid);
+  }
+  // A read error on rank 0 is only known after the bands were sent.
+  MPI_Bcast(&error, 1, MPI_INT, 0, shared_data->grid);
+
+  free(band);
+  free(packed);
+  free(counts);
+  free(displs);
+  MPI_Type_free(&local);
+  return error;
+}
+
+/**
+ * @brief Gathers the blocks of a plate into its output file.
+ *
+ * @details The reverse of scatter_plate(): for each band of grid rows, the
+ * processes of the band send their block without the halo through a vector
+ * datatype, and rank 0 receives them with MPI_Gatherv and writes the rows of
+ * the band. The plate borders never change, so rank 0 copies them from the
+ * input file.
+ *
+ * @param bin_file Input plate file, open on rank 0 only.
+ * @param shared_data Simulation data with the final state in the local
+ * matrix.
+ * @param dir Directory where the binary file will be saved.
+ * @param bin_name Name of the input binary file.
+ * @param sim_states Number of states, used in the output file name.
+ * @param rank The MPI rank of the current process.
+ * @return EXIT_SUCCESS if rank 0 wrote the file, EXIT_FAILURE otherwise.
+ */
+int gather_plate(FILE* bin_file, const SharedData* shared_data,
+  const char* dir, const char* bin_name, uint64_t sim_states, int rank) {
+  const uint64_t rows = shared_data->rows;
+  const uint64_t cols = shared_data->cols;
+  const int* dims = shared_data->dims;
+  int grid_size = 0;
+  MPI_Comm_size(shared_data->grid, &grid_size);
+
+  // The block of the local matrix, without the halo.
+  const Matrix* matrix = &shared_data->matrix;
+  MPI_Datatype inner;
+  MPI_Type_vector((int) (matrix->rows - 2), (int) (matrix->cols - 2),
+    (int) matrix->stride, MPI_DOUBLE, &inner);
+  MPI_Type_commit(&inner);
+
+  int error = EXIT_SUCCESS;
+  FILE* output = NULL;
+  double* band = NULL;
+  double* packed = NULL;
+  int* counts = NULL;
+  int* displs = NULL;
+  if (rank == 0) {
+    char file_name[1024];
+    plate_output_path(file_name, sizeof(file_name), dir, bin_name,
+      sim_states);
+    output = fopen(file_name, "wb");
+    const uint64_t band_rows = max_band_rows(shared_data) + 2;
+    band = malloc(band_rows * cols * sizeof(double));
+    packed = malloc(band_rows * cols * sizeof(double));
+    counts = calloc(grid_size, sizeof(int));
+    displs = calloc(grid_size, sizeof(int));
+    if (!output) {
+      fprintf(stderr, "Failed to create binary file: %s.\n", file_name);
+    }
+    const uint64_t header[2] = {rows, cols};
+    if (!output || !band || !packed || !counts || !displs ||
+      fwrite(header, sizeof(uint64_t), 2, output) != 2) {
+      error = EXIT_FAILURE;
+    }
+  }
+  // Every process must agree on whether the bands are sent.
+  MPI_Bcast(&error, 1, MPI_INT, 0, shared_data->grid);
+  const bool ready = error == EXIT_SUCCESS;
+
+  for (int band_index = 0; ready && band_index < dims[0]; band_index++) {
+    uint64_t first = 0, last = 0;
+    split_range(rows, dims[0], band_index, &first, &last);
+    if (rank == 0) {
+      memset(counts, 0, grid_size * sizeof(int));
+      uint64_t offset = 0;
+      for (int col_index = 0; col_index < dims[1]; col_index++) {
+        const int coords[2] = {band_index, col_index};
+        int source = 0;
+        MPI_Cart_rank(shared_data->grid, coords, &source);
+        uint64_t first_col = 0, last_col = 0;
+        split_range(cols, dims[1], col_index, &first_col, &last_col);
+        counts[source] = (int) ((last - first) * (last_col - first_col));
+        displs[source] = (int) offset;
+        offset += (last - first) * (last_col - first_col);
+      }
+    }
+    const int send = shared_data->coords[0] == band_index ? 1 : 0;
+    MPI_Gatherv(matrix_row(matrix, 1) + 1, send, inner, packed, counts,
+      displs, MPI_DOUBLE, 0, shared_data->grid);
+
+    if (rank == 0) {
+      // The first and last bands also carry the border rows.
+      const uint64_t write_first = band_index == 0 ? 0 : first;
+      const uint64_t write_last = band_index == dims[0] - 1 ? rows : last;
+      if (read_rows(bin_file, cols, write_first, write_last, band) !=
+        EXIT_SUCCESS) {
+        error = EXIT_FAILURE;
+      }
+      for (int col_index = 0; col_index < dims[1]; col_index++) {
+        const int coords[2] = {band_index, col_index};
+        int source = 0;
+        MPI_Cart_rank(shared_data->grid, coords, &source);
+        uint64_t first_col = 0, last_col = 0;
+        split_range(cols, dims[1], col_index, &first_col, &last_col);
+        const uint64_t width = last_col - first_col;
+        for (uint64_t i = 0; i < last - first; i++) {
+          memcpy(band + (first - write_first + i) * cols + first_col,
+            packed + displs[source] + i * width, width * sizeof(double));
+        }
+      }
+      const uint64_t count = (write_last - write_first) * cols;
+      if (error == EXIT_SUCCESS &&
+        fwrite(band, sizeof(double), count, output) != count) {
+        error = EXIT_FAILURE;
+      }
+    }
+  }
+
+  if (rank == 0) {
+    if (output && fclose(output) != 0) {
+      error = EXIT_FAILURE;
+    }
+    if (error != EXIT_SUCCESS) {
+      fprintf(stderr, "Failed to write binary file for: %s.\n", bin_name);
+    }
+  }
+  free(band);
+  free(packed);
+  free(counts);
+  free(displs);
+  MPI_Type_free(&inner);
+  return error;
+}
+
+/**
+ * @brief Reads or writes a region of a plate file with collective MPI-IO.
+ *
+ * @details The file view skips the header and selects the region of the
+ * plate with a subarray datatype, so each process only touches its own cells.
+ * A vector datatype places the region inside the padded local matrix.
+ *
+ * @param file Plate file, open on every process of the grid.
+ * @param shared_data Simulation data with the block and the local matrix.
+ * @param region First row, row after the last one, first column and column
+ * after the last one of the region, in plate coordinates.
+ * @param write true to write the region, false to read it.
+ * @return EXIT_SUCCESS if the whole region was transferred.
+ */
+static int access_region(MPI_File file, const SharedData* shared_data,
+  const uint64_t region[4], bool write) {
+  const Matrix* matrix = &shared_data->matrix;
+  const Block* block = &shared_data->block;
+  const int sizes[2] = {(int) shared_data->rows, (int) shared_data->cols};
+  const int subsizes[2] = {(int) (region[1] - region[0]),
+    (int) (region[3] - region[2])};
+  const int starts[2] = {(int) region[0], (int) region[2]};
+  MPI_Datatype file_type, memory_type;
+  MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C,
+    MPI_DOUBLE, &file_type);
+  MPI_Type_commit(&file_type);
+  MPI_Type_vector(subsizes[0], subsizes[1], (int) matrix->stride, MPI_DOUBLE,
+    &memory_type);
+  MPI_Type_commit(&memory_type);
+
+  // The local matrix starts one row and one column before the block.
+  double* start = matrix_row(matrix, region[0] - (block->first_row - 1)) +
+    region[2] - (block->first_col - 1);
+  int result = MPI_File_set_view(file, 2 * sizeof(uint64_t), MPI_DOUBLE,
+    file_type, "native", MPI_INFO_NULL);
+  if (result == MPI_SUCCESS) {
+    MPI_Status status;
+    result = write ?
+      MPI_File_write_at_all(file, 0, start, 1, memory_type, &status) :
+      MPI_File_read_at_all(file, 0, start, 1, memory_type, &status);
+    int count = 0;
+    if (result == MPI_SUCCESS) {
+      MPI_Get_count(&status, memory_type, &count);
+    }
+    result = count == 1 ? MPI_SUCCESS : MPI_ERR_IO;
+  }
+
+  MPI_Type_free(&file_type);
+  MPI_Type_free(&memory_type);
+  return result == MPI_SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Reads the block of every process straight from the plate file.
+ *
+ * @details The MPI-IO counterpart of scatter_plate(): every process of the
+ * grid reads its block and its halo with one collective read, and no plate
+ * data goes through rank 0. Halos on the plate border are clipped to the
+ * plate, so even plates without inner cells are read.
+ *
+ * @param file_path Path of the plate file, already validated by rank 0.
+ * @param shared_data Simulation data with the process grid and the local
+ * matrices.
+ * @return EXIT_SUCCESS if the plate was read, EXIT_FAILURE otherwise, on
+ * every process of the grid.
+ */
+int read_plate_blocks(const char* file_path, SharedData* shared_data) {
+  const Block* block = &shared_data->block;
+  const uint64_t region[4] = {
+    block->first_row - 1,
+    block->last_row < shared_data->rows ? block->last_row + 1 :
+      shared_data->rows,
+    block->first_col - 1,
+    block->last_col < shared_data->cols ? block->last_col + 1 :
+      shared_data->cols,
+  };
+
+  // Opening is collective, so every process gets the same result.
+  MPI_File file;
+  int error = EXIT_FAILURE;
+  if (MPI_File_open(shared_data->grid, file_path, MPI_MODE_RDONLY,
+    MPI_INFO_NULL, &file) == MPI_SUCCESS) {
+    error = access_region(file, shared_data, region, false);
+    MPI_File_close(&file);
+  }
+  int any_error = EXIT_SUCCESS;
+  MPI_Allreduce(&error, &any_error, 1, MPI_INT, MPI_MAX, shared_data->grid);
+  return any_error;
+}
+
+/**
+ * @brief Writes the block of every process straight into the output file.
+ *
+ * @details The MPI-IO counterpart of gather_plate(): rank 0 writes the
+ * 16-byte header and every process of the grid writes exactly its rows of
+ * the block with one collective write. Processes on the edge of the grid
+ * also write the plate border next to their block, which they hold in their
+ * halo and never changes.
+ *
+ * @param shared_data Simulation data with the final state in the local
+ * matrix.
+ * @param dir Directory where the binary file will be saved.
+ * @param bin_name Name of the input binary file.
+ * @param sim_states Number of states, used in the output file name.
+ * @param rank The MPI rank of the current process.
+ * @return EXIT_SUCCESS if the file was written, EXIT_FAILURE otherwise, on
+ * every process of the grid.
+ */
+int write_plate_blocks(const SharedData* shared_data, const char* dir,
+  const char* bin_name, uint64_t sim_states, int rank) {
+  const uint64_t rows = shared_data->rows;
+  const uint64_t cols = shared_data->cols;
+  const Block* block = &shared_data->block;
+  const int* coords = shared_data->coords;
+  const int* dims = shared_data->dims;
+  uint64_t region[4] = {block->first_row, block->last_row, block->first_col,
+    block->last_col};
+  if (coords[0] == 0) {
+    region[0] = 0;
+  }
+  if (coords[0] == dims[0] - 1) {
+    region[1] = rows;
+  }
+  if (coords[1] == 0) {
+    region[2] = 0;
+  }
+  if (coords[1] == dims[1] - 1) {
+    region[3] = cols;
+  }
+
+  char file_name[1024];
+  plate_output_path(file_name, sizeof(file_name), dir, bin_name, sim_states);
+  MPI_File file;
+  int error = EXIT_FAILURE;
+  if (MPI_File_open(shared_data->grid, file_name,
+    MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file) == MPI_SUCCESS) {
+    // Drop whatever a previous run left after the end of the plate.
+    error = MPI_File_set_size(file, (MPI_Offset) (2 * sizeof(uint64_t) +
+      rows * cols * sizeof(double))) == MPI_SUCCESS ? EXIT_SUCCESS :
+      EXIT_FAILURE;
+    if (rank == 0) {
+      const uint64_t header[2] = {rows, cols};
+      if (MPI_File_write_at(file, 0, header, 2, MPI_UINT64_T,
+        MPI_STATUS_IGNORE) != MPI_SUCCESS) {
+        error = EXIT_FAILURE;
+      }
+    }
+    if (access_region(file, shared_data, region, true) != EXIT_SUCCESS) {
+      error = EXIT_FAILURE;
+    }
+    if (MPI_File_close(&file) != MPI_SUCCESS) {
+      error = EXIT_FAILURE;
+    }
+  }
+  int any_error = EXIT_SUCCESS;
+  MPI_Allreduce(&error, &any_error, 1, MPI_INT, MPI_MAX, shared_data->grid);
+  if (rank == 0 && any_error != EXIT_SUCCESS) {
+    fprintf(stderr, "Failed to write binary file for: %s.\n", bin_name);
+  }
+  return any_error;
+}
@@ -112,44 +112,26 @@ void create_report(const char* dir, const char* job_name, SimData* sim_params,
 }
 
 /**
- * @brief Writes a matrix to a binary file.
+ * @brief Builds the path of the binary file with the final state of a plate.
  *
- * @param matrix Array of double values representing the plate simulation data.
- * @param rows Number of rows in the matrix.
- * @param cols Number of columns in the matrix.
+ * @param path Buffer that receives the path.
+ * @param capacity Capacity of the buffer.
  * @param dir Directory where the binary file will be saved.
- * @param job_name Base name of the job file.
+ * @param bin_name Name of the input binary file.
  * @param sim_states Simulation state identifier used in the output file name.
  */
-void write_plate(double** matrix, uint64_t rows, uint64_t cols,
-  const char* dir, const char* job_name, uint64_t sim_states) {
-  char file_name[1024];
+void plate_output_path(char* path, size_t capacity, const char* dir,
+  const char* bin_name, uint64_t sim_states) {
   char root_name[512];
 
-  // Remove the ".bin" extension from the job name.
-  strncpy(root_name, job_name, sizeof(root_name) - 1);
+  // Remove the ".bin" extension from the plate name.
+  strncpy(root_name, bin_name, sizeof(root_name) - 1);
   root_name[sizeof(root_name) - 1] = '\0';
   char* pos = strstr(root_name, ".bin");
   *pos = '\0';
 
   // Construct the binary file name.
-  snprintf(file_name, sizeof(file_name), "%s/%s-%lu.bin", dir, root_name,
-    sim_states);
-
-  FILE* bin_file = fopen(file_name, "wb");
-  if (bin_file == NULL) {
-    fprintf(stderr, "Failed to create binary file: %s.\n", file_name);
-    return;
-  }
-
-  // Write the matrix dimensions and data to the binary file.
-  fwrite(&rows, sizeof(uint64_t), 1, bin_file);
-  fwrite(&cols, sizeof(uint64_t), 1, bin_file);
-  for (uint64_t i = 0; i < rows; i++) {
-    fwrite(matrix[i], sizeof(double), cols, bin_file);
-  }
-
-  fclose(bin_file);
+  snprintf(path, capacity, "%s/%s-%lu.bin", dir, root_name, sim_states);
 }
 
 /**
@@ -6,50 +6,63 @@
  * @brief Configures and initiates a heat diffusion simulation from a binary
  * plate file.
  *
- * @details This function loads matrix data from a binary file, initializes
- * simulation parameters, and begins the heat diffusion process using the
- * 'simulate' function. The simulation is executed with a specified number of
- * threads, utilizing OpenMP to set the thread count according to system
- * capabilities.
+ * @details This function maps the binary file, copies the plate into the
+ * compute buffer with a parallel bulk copy, initializes simulation
+ * parameters, and begins the heat diffusion process using the
+ * 'simulate' function, or 'simulate_tiled' for plates larger than
+ * TILING_MIN_BYTES, or 'simulate_tasks' for the rest when the task engine
+ * is requested; steady-state lines use 'solve_steady_state'. The simulation is
+ * executed with a specified number of threads, utilizing OpenMP to set the
+ * thread count according to system capabilities. All the job lines of the
+ * group are served by one simulation: it runs until the smallest epsilon is
+ * reached, and the plate is written every time another epsilon reaches
+ * equilibrium. The report is not written here: plates may finish in any
+ * order, and the report must follow the job file order.
  *
- * @param plate_filename The name of the binary file containing the plate's
- * initial state.
- * @param params A SimData structure containing thermal properties and
- * simulation parameters.
- * @param report_file The path to the output file where simulation results will
- * be written.
+ * @param params Parameters of every line of the job file.
+ * @param group Job lines that share the plate, delta, alpha and h.
  * @param input_dir The directory where the binary input file is located.
  * @param thread_count Number of threads to use in the simulation; adjusted to
  * row count if needed.
+ * @param tasks Step plates below TILING_MIN_BYTES with the task engine.
+ * @param states Receives the number of states until equilibrium of every job
+ * line of the group, or the number of V-cycles of a steady-state line.
+ * @param residuals Receives the residual of a steady-state line.
+ * @return EXIT_SUCCESS if the plate was simulated, EXIT_FAILURE otherwise.
  */
-void configure_simulation(const char* plate_filename, SimData params,
-  const char* report_file, const char* input_dir, uint64_t thread_count) {
+int configure_simulation(const SimData* params, const SimGroup* group,
+  const char* input_dir, uint64_t thread_count, bool tasks, uint64_t* states,
+  double* residuals) {
+  const char* plate_filename = group->params.bin_name;
   // Create path to binary file.
   char bin_path[257];
   snprintf(bin_path, sizeof(bin_path), "%s/%s", input_dir, plate_filename);
-  FILE* plate_file = fopen(bin_path, "rb");
-  if (!plate_file) {
+  // Map the file; its header is validated against the file size.
+  PlateMap plate_map;
+  if (plate_map_open(&plate_map, bin_path) != EXIT_SUCCESS) {
     fprintf(stderr, "Could not open binary file.\n");
-    return;
+    return EXIT_FAILURE;
   }
 
-  // Allocate shared data.
+  // Allocate shared data and the epsilons of the group.
   SharedData* shared_data = (SharedData*) calloc(1, sizeof(SharedData));
   assert(shared_data);
-
-  // Read rows and columns.
-  if (fread(&(shared_data->rows), sizeof(uint64_t), 1, plate_file) != 1) {
-    fprintf(stderr, "Error reading the number of rows.\n");
-    fclose(plate_file);
+  double* epsilons = (double*) calloc(group->count, sizeof(double));
+  uint64_t* epsilon_states = (uint64_t*) calloc(group->count,
+    sizeof(uint64_t));
+  if (!epsilons || !epsilon_states) {
+    fprintf(stderr, "Could not allocate memory for epsilons.\n");
+    plate_map_close(&plate_map);
     free(shared_data);
-    return;
+    free(epsilons);
+    free(epsilon_states);
+    return EXIT_FAILURE;
   }
-  if (fread(&(shared_data->cols), sizeof(uint64_t), 1, plate_file) != 1) {
-    fprintf(stderr, "Error reading the number of columns.\n");
-    fclose(plate_file);
-    free(shared_data);
-    return;
+  for (uint64_t i = 0; i < group->count; i++) {
+    epsilons[i] = params[group->lines[i]].epsilon;
   }
+  shared_data->rows = plate_map.rows;
+  shared_data->cols = plate_map.cols;
 
   // Adjust thread count if greater than number of rows.
   if (thread_count > shared_data->rows) {
@@ -57,75 +70,92 @@ void configure_simulation(const char* plate_filename, SimData params,
   }
   omp_set_num_threads(thread_count);
 
-  // Allocate memory for matrix.
-  shared_data->matrix = malloc(shared_data->rows * sizeof(double*));
-  if (!shared_data->matrix) {
-    fprintf(stderr, "Could not allocate memory for matrix rows.\n");
-    fclose(plate_file);
+  // Copy the temperatures into one contiguous, aligned block.
+  if (matrix_load(&shared_data->matrix, &plate_map) != EXIT_SUCCESS) {
+    fprintf(stderr, "Could not allocate memory for matrix.\n");
+    plate_map_close(&plate_map);
     free(shared_data);
-    return;
-  }
-  for (uint64_t i = 0; i < shared_data->rows; i++) {
-    shared_data->matrix[i] = (double*)
-      malloc(shared_data->cols * sizeof(double));
-    if (!shared_data->matrix[i]) {
-      fprintf(stderr, "Could not allocate memory for row %lu.\n", i);
-      for (uint64_t j = 0; j < i; j++) {
-        free(shared_data->matrix[j]);
-      }
-      free(shared_data->matrix);
-      fclose(plate_file);
-      free(shared_data);
-      return;
-    }
+    free(epsilons);
+    free(epsilon_states);
+    return EXIT_FAILURE;
   }
+  plate_map_close(&plate_map);
 
-  // Fill matrix with temperatures.
-  for (uint64_t i = 0; i < shared_data->rows; i++) {
-    for (uint64_t j = 0; j < shared_data->cols; j++) {
-      if (fread(&(shared_data->matrix[i][j]), sizeof(double), 1,
-        plate_file) != 1) {
-        fprintf(stderr, "Error reading matrix data.\n");
-        for (uint64_t k = 0; k < shared_data->rows; k++) {
-          free(shared_data->matrix[k]);
-        }
-        free(shared_data->matrix);
-        fclose(plate_file);
-        free(shared_data);
-        return;
-      }
-    }
-  }
-  fclose(plate_file);
-
-  // Fill shared data with simulation parameters.
-  shared_data->delta = params.delta;
-  shared_data->alpha = params.alpha;
-  shared_data->h = params.h;
-  shared_data->epsilon = params.epsilon;
+  // Fill shared data with simulation parameters. The simulation first aims at
+  // the largest epsilon.
+  shared_data->delta = group->params.delta;
+  shared_data->alpha = group->params.alpha;
+  shared_data->h = group->params.h;
+  shared_data->epsilon = epsilons[0];
+  shared_data->epsilons = epsilons;
+  shared_data->epsilon_states = epsilon_states;
+  shared_data->epsilon_count = group->count;
+  shared_data->reached = 0;
+  shared_data->output_dir = input_dir;
+  shared_data->plate_filename = plate_filename;
 
-  // Start simulation.
-  uint64_t states = 0;
-  simulate(&states, shared_data);
-
-  // Calculate elapsed time.
-  const time_t seconds = states * params.delta;
-  char time[49];
-  format_time(seconds, time, sizeof(time));
-
-  // Write new plate data.
-  write_plate(input_dir, shared_data->matrix, shared_data->rows,
-    shared_data->cols, states, plate_filename);
+  // Start simulation. Plates that do not fit in cache use temporal blocking,
+  // which produces exactly the same states and plates. A steady-state line
+  // is a group of its own and is solved with multigrid instead.
+  uint64_t total_states = 0;
+  int result = EXIT_SUCCESS;
+  if (group->params.steady) {
+    result = solve_steady_state(shared_data, &epsilon_states[0],
+      &residuals[group->lines[0]]);
+  } else if (shared_data->rows * shared_data->matrix.stride * sizeof(double) >=
+    TILING_MIN_BYTES) {
+    simulate_tiled(&total_states, shared_data);
+  } else if (tasks) {
+    simulate_tasks(&total_states, shared_data);
+  } else {
+    simulate(&total_states, shared_data);
+  }
 
-  // Write report.
-  create_report(report_file, states, time, params, plate_filename);
+  // Store the states of every job line of the group.
+  for (uint64_t i = 0; i < group->count; i++) {
+    states[group->lines[i]] = epsilon_states[i];
+  }
 
   // Free memory.
-  for (uint64_t i = 0; i < shared_data->rows; i++) {
-    free(shared_data->matrix[i]);
-  }
-  free(shared_data->matrix);
+  matrix_destroy(&shared_data->matrix);
   free(shared_data);
+  free(epsilons);
+  free(epsilon_states);
+  return result;
+}
+
+/**
+ * @brief Records the epsilons that reached equilibrium in a state.
+ *
+ * @details A state is at equilibrium for an epsilon when no cell changed by
+ * epsilon or more. Since the epsilons are in decreasing order, every epsilon
+ * that reaches equilibrium in this state follows the ones recorded before.
+ * When at least one is recorded, the current plate is written, and the next
+ * epsilon becomes the target of the simulation.
+ *
+ * @param shared_data Simulation data; 'matrix' must hold the given state.
+ * @param state Number of the state that was just computed.
+ * @param max_delta Largest absolute change of a cell in this state.
+ * @return true if every epsilon of the group reached equilibrium.
+ */
+bool record_equilibrium(SharedData* shared_data, uint64_t state,
+  double max_delta) {
+  bool recorded = false;
+  while (shared_data->reached < shared_data->epsilon_count &&
+    max_delta < shared_data->epsilons[shared_data->reached]) {
+    shared_data->epsilon_states[shared_data->reached++] = state;
+    recorded = true;
+  }
+  if (recorded) {
+    // Write new plate data.
+    write_plate(shared_data->output_dir, &shared_data->matrix, state,
+      shared_data->plate_filename);
+  }
+  if (shared_data->reached < shared_data->epsilon_count) {
+    shared_data->epsilon = shared_data->epsilons[shared_data->reached];
+    return false;
+  }
+  return true;
 }
 
 /**
@@ -134,9 +164,14 @@ void configure_simulation(const char* plate_filename, SimData params,
  * @details This function iteratively calculates heat distribution in a matrix
  * until equilibrium is achieved, using OpenMP for parallel processing to
  * improve speed.
- * The function uses OpenMP to parallelize both matrix copying and heat
- * calculations, optimizing for faster execution. Memory for the matrix copy is
- * freed upon completion.
+ * The function uses OpenMP to parallelize the heat calculations. A single
+ * parallel region covers the whole time loop: the rows of each state are
+ * split among the threads, their largest change is combined with a max
+ * reduction, and one thread swaps the buffers and checks the epsilons, so
+ * each state costs two barriers and no fork or join. Two buffers swap roles
+ * after every state, so no data is copied between states. The
+ * second buffer is freed upon completion. The simulation runs until every
+ * epsilon of the group reaches equilibrium, writing the plate at each one.
  *
  * @param states Pointer to store the number of iterations required to reach
  * equilibrium.
@@ -144,11 +179,13 @@ void configure_simulation(const char* plate_filename, SimData params,
  * dimensions, and thermal properties for the simulation.
  */
 void simulate(uint64_t* states, SharedData* shared_data) {
-  // Allocate memory for matrix copy.
-  double** matrix_copy = (double**)
-    malloc(shared_data->rows * sizeof(double*));
-  for (uint64_t i = 0; i < shared_data->rows; i++) {
-    matrix_copy[i] = (double*) malloc(shared_data->cols * sizeof(double));
+  // Reserve the buffer for the next state. Borders never change, so they are
+  // copied only once, by the threads that compute the rows next to them.
+  Matrix next_matrix;
+  if (matrix_reserve(&next_matrix, shared_data->rows, shared_data->cols)
+    != EXIT_SUCCESS) {
+    fprintf(stderr, "Could not allocate memory for matrix copy.\n");
+    return;
   }
 
   uint64_t state = 0;
@@ -156,59 +193,68 @@ void simulate(uint64_t* states, SharedData* shared_data) {
   const double delta = shared_data->delta;
   const double h = shared_data->h;
   const double alpha = shared_data->alpha;
-  double** matrix = shared_data->matrix;
-  const double epsilon = shared_data->epsilon;
+  const Matrix* matrix = &shared_data->matrix;
+  const uint64_t rows = shared_data->rows;
+  const uint64_t cols = shared_data->cols;
+  const double factor = delta * alpha / (h * h);  ///< Same for every cell.
 
-  while (!equilibrium) {
-    state++;
+  // Plates without inner rows have nothing to split.
+  const uint64_t inner_end = rows > 2 ? rows - 1 : 1;
 
-    // Copy matrix.
-    #pragma omp parallel for collapse(2)
-    for (uint64_t i = 0; i < shared_data->rows; i++) {
-      for (uint64_t j = 0; j < shared_data->cols; j++) {
-        matrix_copy[i][j] = matrix[i][j];
-      }
+  // Largest change of the state, compared against every epsilon.
+  double max_delta = 0.0;
+  // One team of threads computes every state; only the single construct at
+  // the end of a state is serial. The threads are bound like the ones of
+  // matrix_load(), so with OMP_PLACES set each one keeps its NUMA node.
+  #pragma omp parallel default(shared) proc_bind(spread)
+  {
+    // Each thread first touches the rows it computes, with the same static
+    // schedule, so the next state lands on the same NUMA node as the current
+    // one.
+    #pragma omp for schedule(static)
+    for (uint64_t i = 1; i < inner_end; i++) {
+      matrix_copy_rows(&next_matrix, matrix, i == 1 ? 0 : i,
+        i == rows - 2 ? rows : i + 1);
+    }
+    #pragma omp single
+    if (rows < 3) {
+      matrix_copy_rows(&next_matrix, matrix, 0, rows);
     }
 
-    // Ensure matrix copy is complete before calculations.
-    #pragma omp barrier
-
-    bool local_equilibrium = true;
-    #pragma omp parallel
-    {
-      bool thread_equilibrium = true;
-
-      #pragma omp for collapse(2) schedule(static)
-      for (uint64_t i = 1; i < shared_data->rows - 1; i++) {
-        for (uint64_t j = 1; j < shared_data->cols - 1; j++) {
-          double cell = matrix_copy[i][j];
-          double cells_around = matrix_copy[i-1][j] + matrix_copy[i][j+1] +
-            matrix_copy[i+1][j] + matrix_copy[i][j-1];
-          double new_temp = cell + (delta * alpha / (h * h)) *
-            (cells_around - 4 * cell);
-          matrix[i][j] = new_temp;
-
-          if (fabs(new_temp - cell) >= epsilon) {
-            thread_equilibrium = false;
-          }
+    while (!equilibrium) {
+      #pragma omp for schedule(static) reduction(max:max_delta)
+      for (uint64_t i = 1; i < inner_end; i++) {
+        const double* up = matrix_row(matrix, i - 1);
+        const double* row = matrix_row(matrix, i);
+        const double* down = matrix_row(matrix, i + 1);
+        double* next = matrix_row(&next_matrix, i);
+        // Compute the whole row with the vector kernel for this CPU.
+        const double row_delta = stencil_row(up, row, down, next, cols,
+          factor);
+        if (row_delta > max_delta) {
+          max_delta = row_delta;
         }
       }
 
-      // Critical section with minimal overhead.
-      #pragma omp critical
+      #pragma omp single
       {
-        if (!thread_equilibrium) local_equilibrium = false;
+        state++;
+        // Swap buffers: the new state becomes the current one.
+        Matrix temp = shared_data->matrix;
+        shared_data->matrix = next_matrix;
+        next_matrix = temp;
+
+        // Record the epsilons that reached equilibrium in this state.
+        if (max_delta < shared_data->epsilon) {
+          equilibrium = record_equilibrium(shared_data, state, max_delta);
+        }
+        max_delta = 0.0;
       }
     }
-
-    equilibrium = local_equilibrium;
   }
 
   *states = state;
 
   // Free memory.
-  for (uint64_t i = 0; i < shared_data->rows; i++) {
-    free(matrix_copy[i]);
-  }
-  free(matrix_copy);
+  matrix_destroy(&next_matrix);
 }
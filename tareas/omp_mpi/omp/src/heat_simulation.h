@@ -6,6 +6,57 @@
 // Specify the maximum size allowed for file paths.
 #define MAX_PATH_LENGTH 1024
 
+// Plates of at least this many bytes run with the temporal blocking engine.
+// Smaller plates usually fit in the last level cache, where a plain sweep per
+// state is faster. Can be overridden at build time, e.g. DEFS=-D...=0.
+#ifndef TILING_MIN_BYTES
+#define TILING_MIN_BYTES (64 * 1024 * 1024)
+#endif
+
+// Cache budget for the two scratch buffers of a tile, per thread.
+#ifndef TILING_CACHE_BYTES
+#define TILING_CACHE_BYTES (1024 * 1024)
+#endif
+
+// Number of states each tile advances before moving to the next one.
+#ifndef TILING_STEPS
+#define TILING_STEPS 8
+#endif
+
+// Bands of rows per thread in the task engine.
+#ifndef TASK_BANDS_PER_THREAD
+#define TASK_BANDS_PER_THREAD 4
+#endif
+
+// State buffers in the ring of the task engine. Bands may run up to this
+// many states minus one ahead of the last checked one.
+#ifndef TASK_LOOKAHEAD
+#define TASK_LOOKAHEAD 4
+#endif
+#if TASK_LOOKAHEAD < 2
+#error "TASK_LOOKAHEAD must be at least 2"
+#endif
+
+// Job lines whose sixth field is "multigrid" are solved for the steady state
+// with V-cycles instead of time stepping. These set the number of levels, the
+// red-black Gauss-Seidel sweeps before and after the coarse correction and on
+// the coarsest level, and the cycles before giving up.
+#ifndef MULTIGRID_MAX_LEVELS
+#define MULTIGRID_MAX_LEVELS 16
+#endif
+#ifndef MULTIGRID_PRE_SWEEPS
+#define MULTIGRID_PRE_SWEEPS 2
+#endif
+#ifndef MULTIGRID_POST_SWEEPS
+#define MULTIGRID_POST_SWEEPS 2
+#endif
+#ifndef MULTIGRID_COARSE_SWEEPS
+#define MULTIGRID_COARSE_SWEEPS 32
+#endif
+#ifndef MULTIGRID_MAX_CYCLES
+#define MULTIGRID_MAX_CYCLES 200
+#endif
+
 #include <assert.h>
 #include <inttypes.h>
 #include <math.h>
@@ -18,6 +69,9 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "matrix.h"
+#include "stencil.h"
+
 /**
  * @brief Structure that stores the simulation parameters.
  *
@@ -28,8 +82,23 @@ typedef struct simulation_parameters {
   char bin_name[256];
   double alpha, epsilon;
   uint64_t delta, h;
+  bool steady;  ///< Solve the steady state with multigrid, without states.
+  bool malformed;  ///< The line could not be parsed and is not simulated.
 } SimData;
 
+/**
+ * @brief Job lines that only differ in epsilon.
+ *
+ * @details All the lines of a group follow the same trajectory, so they are
+ * simulated once. Each line converges at a prefix of the trajectory of the
+ * lines with a smaller epsilon.
+ */
+typedef struct simulation_group {
+  SimData params;         ///< Shared parameters; epsilon is the smallest one.
+  const uint64_t* lines;  ///< Job lines of the group, by decreasing epsilon.
+  uint64_t count;         ///< Number of job lines in the group.
+} SimGroup;
+
 /**
  * @brief Structure that stores the data shared between the threads for the
  * simulation.
@@ -38,23 +107,52 @@ typedef struct simulation_parameters {
  * well as the data matrix that represents the temperatures of each cell.
  */
 typedef struct shared_thread_data {
-  double** matrix;
+  Matrix matrix;
   uint64_t cols, rows, delta, h;
-  double alpha, epsilon;
+  double alpha, epsilon;  ///< Epsilon of the next line to reach equilibrium.
+  const double* epsilons;  ///< Epsilons of the group, in decreasing order.
+  uint64_t* epsilon_states;  ///< Receives the states of every epsilon.
+  uint64_t epsilon_count;  ///< Number of epsilons of the group.
+  uint64_t reached;  ///< Number of epsilons that already reached equilibrium.
+  const char* output_dir;  ///< Directory for the resulting plates.
+  const char* plate_filename;  ///< Name of the initial plate file.
 } SharedData;
 
 // Declaration of functions related to heat simulation.
-void configure_simulation(const char* plate_filename, SimData params,
-  const char* filepath, const char* input_dir, uint64_t thread_count);
+int configure_simulation(const SimData* params, const SimGroup* group,
+  const char* input_dir, uint64_t thread_count, bool tasks, uint64_t* states,
+  double* residuals);
 void simulate(uint64_t* states, SharedData* shared_data);
+bool record_equilibrium(SharedData* shared_data, uint64_t state,
+  double max_delta);
+
+// Declaration of the job scheduler in scheduler.c.
+void schedule_job(const SimData* params, uint64_t count, const char* input_dir,
+  uint64_t thread_count, bool tasks, uint64_t* states, double* residuals,
+  int* results);
+
+// Declaration of the temporal blocking engine in tiling.c.
+void simulate_tiled(uint64_t* states, SharedData* shared_data);
+
+// Declaration of the task engine in tasks.c.
+void simulate_tasks(uint64_t* states, SharedData* shared_data);
+
+// Declaration of the steady-state solver in multigrid.c.
+int solve_steady_state(SharedData* shared_data, uint64_t* cycles,
+  double* residual);
 
 // Declaration of auxiliary functions in utils.c.
 uint64_t count_job_lines(FILE* bin_name);
 SimData* read_job_file(const char* job_file, uint64_t* struct_count);
+SimGroup* group_job_lines(const SimData* params, uint64_t count,
+  uint64_t* lines, uint64_t* group_count);
 void create_report(const char* report_file, uint64_t states, const char* time,
   SimData params, const char* plate_filename);
-void write_plate(const char* output_dir, double** data, uint64_t rows,
-  uint64_t cols, uint64_t states, const char* plate_filename);
+void create_steady_report(const char* report_file, uint64_t cycles,
+  double residual, SimData params);
+void write_plate(const char* output_dir, const Matrix* matrix,
+  uint64_t states, const char* plate_filename);
+void write_plate_file(const char* path, const Matrix* matrix);
 char* format_time(const time_t seconds, char* text, const size_t capacity);
 
 #endif  // HEAT_SIMULATION_H
@@ -22,11 +22,31 @@
  * user-specified number of threads or detect the number of available
  * processors to determine the number of threads to create. The number of
  * threads entered is used to perform operations on the array, distributing the
- * work equally among them.
+ * work equally among them. A job line may end with "multigrid" to solve the
+ * steady state of its plate instead; its report line holds the number of
+ * V-cycles and the residual instead of the states and the time. With the
+ * --tasks option, in any position, plates that are not tiled are stepped by
+ * the task engine instead of one sweep per state.
  */
 int main(int argc, char *argv[]) {
   double start_time = omp_get_wtime();  ///< OpenMP timing.
 
+  // Select the simulation kernel for this CPU.
+  stencil_init();
+
+  // Remove the --tasks option from the arguments, in any position.
+  bool tasks = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--tasks") == 0) {
+      tasks = true;
+      for (int j = i; j < argc - 1; j++) {
+        argv[j] = argv[j + 1];
+      }
+      argc--;
+      i--;
+    }
+  }
+
   // Verify command line arguments.
   if (argc < 4 || argc > 5) {
     /**
@@ -39,7 +59,7 @@ int main(int argc, char *argv[]) {
      * thread count is not provided).
      */
     fprintf(stderr, "Usage: bin/omp_mpi <job file> <input dir> <output dir> "
-      "<thread_count>\n");
+      "<thread_count> [--tasks]\n");
     return 11;
   }
   const char* job_filename = argv[1];
@@ -49,7 +69,8 @@ int main(int argc, char *argv[]) {
   // Configure thread count.
   uint64_t thread_count = sysconf(_SC_NPROCESSORS_ONLN);
   if (argc == 5) {
-    if (sscanf(argv[4], "%" SCNu64, &thread_count) != 1) {
+    if (sscanf(argv[4], "%" SCNu64, &thread_count) != 1 ||
+      thread_count == 0) {
       fprintf(stderr, "Invalid thread count.\n");
       return 12;
     }
@@ -87,13 +108,41 @@ int main(int argc, char *argv[]) {
     return 1;
   }
 
-  // Run simulation.
-  const char* plate_filename;
+  uint64_t* states = (uint64_t*) calloc(struct_count, sizeof(uint64_t));
+  double* residuals = (double*) calloc(struct_count, sizeof(double));
+  int* results = (int*) calloc(struct_count, sizeof(int));
+  if (!states || !residuals || !results) {
+    fprintf(stderr, "Could not allocate memory for job results.\n");
+    free(states);
+    free(residuals);
+    free(results);
+    free(simulation_parameters);
+    return 1;
+  }
+
+  // Run the simulations, several plates at a time.
+  schedule_job(simulation_parameters, struct_count, input_dir, thread_count,
+    tasks, states, residuals, results);
+
+  // Write the report in job file order.
   for (uint64_t i = 0; i < struct_count; i++) {
-    plate_filename = simulation_parameters[i].bin_name;
-    configure_simulation(plate_filename, simulation_parameters[i], report_path,
-      input_dir, thread_count);
+    if (results[i] != EXIT_SUCCESS) {
+      continue;
+    }
+    if (simulation_parameters[i].steady) {
+      create_steady_report(report_path, states[i], residuals[i],
+        simulation_parameters[i]);
+      continue;
+    }
+    const time_t seconds = states[i] * simulation_parameters[i].delta;
+    char time[49];
+    format_time(seconds, time, sizeof(time));
+    create_report(report_path, states[i], time, simulation_parameters[i],
+      simulation_parameters[i].bin_name);
   }
+  free(states);
+  free(residuals);
+  free(results);
 
   // Calculate elapsed time using OpenMP timing.
   double end_time = omp_get_wtime();
@@ -0,0 +1,215 @@
+// Copyright 2024 Josue Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+// Map files into memory.
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <omp.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "matrix.h"
+
+/**
+ * @brief Reserves a contiguous matrix aligned to cache lines, without
+ * touching it.
+ *
+ * @details The width of every row is rounded up to a multiple of a cache
+ * line, so all rows start at the same offset relative to a line. No cell is
+ * written, so each page lands on the NUMA node of the thread that first
+ * writes it.
+ *
+ * @param matrix Matrix to initialize.
+ * @param rows Number of plate rows.
+ * @param cols Number of plate columns.
+ * @return EXIT_SUCCESS if the memory was allocated, EXIT_FAILURE otherwise.
+ */
+int matrix_reserve(Matrix* matrix, uint64_t rows, uint64_t cols) {
+  matrix->rows = rows;
+  matrix->cols = cols;
+  matrix->stride = (MATRIX_LEAD + cols + 1 + CACHE_LINE_DOUBLES - 1) /
+    CACHE_LINE_DOUBLES * CACHE_LINE_DOUBLES;
+  // The size of the block must not overflow.
+  matrix->buffer = NULL;
+  if (matrix->stride > cols &&
+    rows <= SIZE_MAX / sizeof(double) / matrix->stride) {
+    matrix->buffer = (double*) aligned_alloc(CACHE_LINE_SIZE,
+      rows * matrix->stride * sizeof(double));
+  }
+  if (!matrix->buffer) {
+    matrix->data = NULL;
+    return EXIT_FAILURE;
+  }
+  matrix->data = matrix->buffer + MATRIX_LEAD;
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Zeroes the ghost columns of a row.
+ *
+ * @param matrix Matrix that holds the row.
+ * @param row Row to clear.
+ */
+static void clear_ghosts(const Matrix* matrix, uint64_t row) {
+  double* cells = matrix_row(matrix, row);
+  memset(cells - MATRIX_LEAD, 0, MATRIX_LEAD * sizeof(double));
+  memset(cells + matrix->cols, 0,
+    (matrix->stride - MATRIX_LEAD - matrix->cols) * sizeof(double));
+}
+
+/**
+ * @brief Allocates a contiguous matrix aligned to cache lines.
+ *
+ * @details Only the ghost columns are zeroed; plate columns stay
+ * uninitialized until they are read from the file.
+ *
+ * @param matrix Matrix to initialize.
+ * @param rows Number of plate rows.
+ * @param cols Number of plate columns.
+ * @return EXIT_SUCCESS if the memory was allocated, EXIT_FAILURE otherwise.
+ */
+int matrix_create(Matrix* matrix, uint64_t rows, uint64_t cols) {
+  if (matrix_reserve(matrix, rows, cols) != EXIT_SUCCESS) {
+    return EXIT_FAILURE;
+  }
+  for (uint64_t i = 0; i < rows; i++) {
+    clear_ghosts(matrix, i);
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Copies rows [first, last) of a matrix, ghost columns included.
+ *
+ * @param target Matrix that receives the rows; same layout as 'source'.
+ * @param source Matrix to copy from.
+ * @param first First row to copy.
+ * @param last Row after the last one to copy.
+ */
+void matrix_copy_rows(Matrix* target, const Matrix* source, uint64_t first,
+  uint64_t last) {
+  if (first < last) {
+    memcpy(target->buffer + first * target->stride,
+      source->buffer + first * source->stride,
+      (last - first) * source->stride * sizeof(double));
+  }
+}
+
+/**
+ * @brief Releases the memory block of the matrix.
+ *
+ * @param matrix Matrix to release.
+ */
+void matrix_destroy(Matrix* matrix) {
+  free(matrix->buffer);
+  matrix->buffer = NULL;
+  matrix->data = NULL;
+}
+
+/**
+ * @brief Allocates a matrix and fills it with the temperatures of a plate.
+ *
+ * @details The temperatures are copied from the mapping in one bulk copy,
+ * split by rows among the OpenMP threads with the same static schedule and
+ * thread binding used by simulate(), so each thread is the first to touch its
+ * rows and they land on its NUMA node. The border rows go with the first and
+ * last inner rows, which read them.
+ *
+ * @param matrix Matrix to initialize.
+ * @param map Mapped plate file.
+ * @return EXIT_SUCCESS if the matrix was loaded, EXIT_FAILURE otherwise.
+ */
+int matrix_load(Matrix* matrix, const PlateMap* map) {
+  if (matrix_reserve(matrix, map->rows, map->cols) != EXIT_SUCCESS) {
+    return EXIT_FAILURE;
+  }
+  // Ask the kernel to read the whole file ahead.
+  posix_madvise(map->address, map->length, POSIX_MADV_WILLNEED);
+
+  const uint64_t rows = map->rows;
+  const uint64_t cols = map->cols;
+  // Plates without inner rows have nothing to split.
+  const uint64_t inner_end = rows > 2 ? rows - 1 : 1;
+  #pragma omp parallel for schedule(static) proc_bind(spread)
+  for (uint64_t i = 1; i < inner_end; i++) {
+    const uint64_t first = i == 1 ? 0 : i;
+    const uint64_t last = i == rows - 2 ? rows : i + 1;
+    for (uint64_t row = first; row < last; row++) {
+      clear_ghosts(matrix, row);
+      memcpy(matrix_row(matrix, row), map->cells + row * cols,
+        cols * sizeof(double));
+    }
+  }
+  for (uint64_t row = 0; rows < 3 && row < rows; row++) {
+    clear_ghosts(matrix, row);
+    memcpy(matrix_row(matrix, row), map->cells + row * cols,
+      cols * sizeof(double));
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Maps a plate file into memory and validates its header.
+ *
+ * @details The file must hold exactly the 16-byte header plus rows * cols
+ * doubles; a truncated or oversized file is rejected before any temperature
+ * is read.
+ *
+ * @param map Receives the mapping.
+ * @param path Path of the plate file.
+ * @return EXIT_SUCCESS if the file was mapped, EXIT_FAILURE otherwise.
+ */
+int plate_map_open(PlateMap* map, const char* path) {
+  memset(map, 0, sizeof(PlateMap));
+  const int file = open(path, O_RDONLY);
+  if (file < 0) {
+    return EXIT_FAILURE;
+  }
+  struct stat info;
+  const uint64_t header_size = 2 * sizeof(uint64_t);
+  if (fstat(file, &info) != 0 || (uint64_t) info.st_size < header_size) {
+    close(file);
+    return EXIT_FAILURE;
+  }
+  void* address = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE,
+    file, 0);
+  close(file);
+  if (address == MAP_FAILED) {
+    return EXIT_FAILURE;
+  }
+
+  // The payload must match the header exactly, checking for overflow. A plate
+  // without rows or columns is rejected too: its empty payload would match
+  // any number of the other dimension.
+  const uint64_t* header = (const uint64_t*) address;
+  const uint64_t rows = header[0];
+  const uint64_t cols = header[1];
+  const uint64_t payload = (uint64_t) info.st_size - header_size;
+  if (rows == 0 || cols == 0 || rows > payload / sizeof(double) / cols ||
+    rows * cols * sizeof(double) != payload) {
+    fprintf(stderr, "Plate file %s does not match its header.\n", path);
+    munmap(address, (size_t) info.st_size);
+    return EXIT_FAILURE;
+  }
+
+  map->address = address;
+  map->length = (size_t) info.st_size;
+  map->rows = rows;
+  map->cols = cols;
+  map->cells = (const double*) ((const char*) address + header_size);
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Unmaps a plate file.
+ *
+ * @param map Mapping to release.
+ */
+void plate_map_close(PlateMap* map) {
+  if (map->address) {
+    munmap(map->address, map->length);
+  }
+  memset(map, 0, sizeof(PlateMap));
+}
@@ -0,0 +1,67 @@
+// Copyright 2024 Josue Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Size in bytes of a cache line.
+#define CACHE_LINE_SIZE 64
+
+// Number of doubles that fit in a cache line.
+#define CACHE_LINE_DOUBLES (CACHE_LINE_SIZE / sizeof(double))
+
+// Ghost columns before column 0 of every row. With this value the first
+// interior column (column 1) starts on a cache line boundary.
+#define MATRIX_LEAD (CACHE_LINE_DOUBLES - 1)
+
+/**
+ * @brief Temperature matrix stored in a single contiguous block.
+ *
+ * @details Every row lives in one block aligned to cache lines. Each row takes
+ * 'stride' doubles: MATRIX_LEAD ghost columns, the 'cols' plate columns and at
+ * least one trailing ghost column, padded to a whole cache line. Element
+ * (i, j) is found at data[i * stride + j]. Ghost columns are always zero.
+ */
+typedef struct matrix {
+  double* buffer;    ///< Allocated block, including ghost columns.
+  double* data;      ///< Column 0 of row 0 inside the block.
+  uint64_t rows;     ///< Number of plate rows.
+  uint64_t cols;     ///< Number of plate columns.
+  uint64_t stride;   ///< Distance in doubles between consecutive rows.
+} Matrix;
+
+/**
+ * @brief Plate file mapped into memory.
+ *
+ * @details A plate file holds the number of rows and columns as two 8-byte
+ * integers followed by the temperatures, row by row and without padding. The
+ * mapping is read-only, so the header and the temperatures can be scanned in
+ * place without copying them.
+ */
+typedef struct plate_map {
+  void* address;        ///< Start of the mapping.
+  size_t length;        ///< Length of the mapping in bytes.
+  uint64_t rows;        ///< Number of plate rows.
+  uint64_t cols;        ///< Number of plate columns.
+  const double* cells;  ///< Temperatures, rows * cols values.
+} PlateMap;
+
+int matrix_reserve(Matrix* matrix, uint64_t rows, uint64_t cols);
+int matrix_create(Matrix* matrix, uint64_t rows, uint64_t cols);
+void matrix_destroy(Matrix* matrix);
+void matrix_copy_rows(Matrix* target, const Matrix* source, uint64_t first,
+  uint64_t last);
+int matrix_load(Matrix* matrix, const PlateMap* map);
+
+int plate_map_open(PlateMap* map, const char* path);
+void plate_map_close(PlateMap* map);
+
+// Returns a pointer to column 0 of the given row.
+static inline double* matrix_row(const Matrix* matrix, uint64_t row) {
+  return matrix->data + row * matrix->stride;
+}
+
+#endif  // MATRIX_H
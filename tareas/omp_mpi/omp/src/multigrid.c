@@ -0,0 +1,405 @@
+// Copyright 2024 Josue Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+#include "heat_simulation.h"
+
+/**
+ * @brief Weights of the 1D second difference of a cell.
+ *
+ * @details The difference is before * e[-1] + after * e[+1] - center * e[0].
+ * Every cell uses (1, 1, 2) except the last inner cell of a coarse level,
+ * whose border can be closer than one cell.
+ */
+typedef struct edge_weights {
+  double before, after, center;
+} EdgeWeights;
+
+/**
+ * @brief One grid of the multigrid hierarchy.
+ *
+ * @details Level 0 is the plate itself, with its borders fixed. Coarser
+ * levels hold the correction of the level above: every coarse cell (I, J)
+ * sits on fine cell (2I, 2J), and their borders are always zero and lie on
+ * the borders of the plate. When a fine dimension is even, the fine border is
+ * only half a coarse cell away from the last coarse inner cell, so each level
+ * keeps that distance, its 'tail', for the last inner row and column. All the
+ * matrices of a level have the same shape, including the borders.
+ */
+typedef struct multigrid_level {
+  Matrix* solution;  ///< Plate on level 0, correction on coarser levels.
+  Matrix correction;  ///< Storage of 'solution' on coarser levels.
+  Matrix rhs;  ///< Right-hand side; unused on level 0, where it is 0.
+  Matrix residual;  ///< Residual of the level; borders are always zero.
+  double spacing;  ///< Squared cell size, relative to the plate.
+  double row_tail, col_tail;  ///< Distance from the last inner cell to the
+                              ///< border, in cells of this level.
+  EdgeWeights last_row, last_col;  ///< Weights of the last inner cells.
+} MultigridLevel;
+
+// Weights of every cell that is not the last inner one.
+static const EdgeWeights kUniformWeights = {1.0, 1.0, 2.0};
+
+/**
+ * @brief Computes the weights of a cell one cell away from its previous
+ * neighbor and 'tail' cells away from the border after it.
+ *
+ * @param tail Distance to the border, in (0, 1].
+ * @return Weights of the non-uniform second difference.
+ */
+static EdgeWeights tail_weights(double tail) {
+  const EdgeWeights weights = {2.0 / (1.0 + tail),
+    2.0 / (tail * (1.0 + tail)), 2.0 / tail};
+  return weights;
+}
+
+/**
+ * @brief Allocates a matrix whose cells and ghost columns are all zero.
+ *
+ * @param matrix Matrix to create.
+ * @param rows Number of rows, including the borders.
+ * @param cols Number of columns, including the borders.
+ * @return EXIT_SUCCESS if the matrix was allocated, EXIT_FAILURE otherwise.
+ */
+static int create_zero_matrix(Matrix* matrix, uint64_t rows, uint64_t cols) {
+  if (matrix_create(matrix, rows, cols) != EXIT_SUCCESS) {
+    return EXIT_FAILURE;
+  }
+  memset(matrix->buffer, 0, rows * matrix->stride * sizeof(double));
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Frees the matrices of the levels.
+ *
+ * @param levels Levels of the hierarchy.
+ * @param count Number of levels.
+ */
+static void destroy_levels(MultigridLevel* levels, uint64_t count) {
+  for (uint64_t level = 0; level < count; level++) {
+    matrix_destroy(&levels[level].correction);
+    matrix_destroy(&levels[level].rhs);
+    matrix_destroy(&levels[level].residual);
+  }
+}
+
+/**
+ * @brief Builds the hierarchy of grids below the plate.
+ *
+ * @details Every level keeps the fine cells with even indices, plus a
+ * border, until a level would have no inner cells or MULTIGRID_MAX_LEVELS is
+ * reached.
+ *
+ * @param levels Receives the levels.
+ * @param plate Plate of the simulation, used as level 0.
+ * @return Number of levels, or 0 if memory could not be allocated.
+ */
+static uint64_t create_levels(MultigridLevel* levels, Matrix* plate) {
+  memset(levels, 0, MULTIGRID_MAX_LEVELS * sizeof(MultigridLevel));
+  levels[0].solution = plate;
+  levels[0].spacing = 1.0;
+  levels[0].row_tail = levels[0].col_tail = 1.0;
+  levels[0].last_row = levels[0].last_col = kUniformWeights;
+  if (create_zero_matrix(&levels[0].residual, plate->rows, plate->cols)
+    != EXIT_SUCCESS) {
+    return 0;
+  }
+  uint64_t count = 1;
+  while (count < MULTIGRID_MAX_LEVELS) {
+    const MultigridLevel* fine = &levels[count - 1];
+    const uint64_t fine_rows = fine->solution->rows;
+    const uint64_t fine_cols = fine->solution->cols;
+    if (fine_rows < 4 || fine_cols < 4) {
+      break;
+    }
+    // The last coarse inner cell sits on the last even fine inner cell.
+    MultigridLevel* level = &levels[count++];
+    level->solution = &level->correction;
+    level->spacing = fine->spacing * 4.0;
+    level->row_tail = (fine_rows % 2 == 0 ? fine->row_tail :
+      1.0 + fine->row_tail) / 2.0;
+    level->col_tail = (fine_cols % 2 == 0 ? fine->col_tail :
+      1.0 + fine->col_tail) / 2.0;
+    level->last_row = tail_weights(level->row_tail);
+    level->last_col = tail_weights(level->col_tail);
+    const uint64_t rows = fine_rows / 2 + 1;
+    const uint64_t cols = fine_cols / 2 + 1;
+    if (create_zero_matrix(&level->correction, rows, cols) != EXIT_SUCCESS ||
+      create_zero_matrix(&level->rhs, rows, cols) != EXIT_SUCCESS ||
+      create_zero_matrix(&level->residual, rows, cols) != EXIT_SUCCESS) {
+      destroy_levels(levels, count);
+      return 0;
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief Runs red-black Gauss-Seidel sweeps on a level.
+ *
+ * @details Cells with an even i + j are updated first, then the odd ones.
+ * The cells of one color only read cells of the other color, so the rows of
+ * each color are split among the threads and the result does not depend on
+ * the number of threads. Must be called by every thread of the team.
+ *
+ * @param level Level to smooth.
+ * @param sweeps Number of sweeps.
+ */
+static void smooth(const MultigridLevel* level, uint64_t sweeps) {
+  const Matrix* solution = level->solution;
+  const Matrix* rhs = level->rhs.buffer ? &level->rhs : NULL;
+  const uint64_t rows = solution->rows;
+  const uint64_t cols = solution->cols;
+  for (uint64_t sweep = 0; sweep < 2 * sweeps; sweep++) {
+    const uint64_t color = sweep % 2;
+    #pragma omp for schedule(static)
+    for (uint64_t i = 1; i < rows - 1; i++) {
+      const EdgeWeights y = i == rows - 2 ? level->last_row : kUniformWeights;
+      const double* up = matrix_row(solution, i - 1);
+      double* row = matrix_row(solution, i);
+      const double* down = matrix_row(solution, i + 1);
+      const double* source = rhs ? matrix_row(rhs, i) : NULL;
+      for (uint64_t j = (i + 1) % 2 == color ? 1 : 2; j < cols - 1; j += 2) {
+        const EdgeWeights x = j == cols - 2 ? level->last_col :
+          kUniformWeights;
+        const double sum = y.before * up[j] + y.after * down[j] +
+          x.before * row[j - 1] + x.after * row[j + 1] +
+          (source ? level->spacing * source[j] : 0.0);
+        row[j] = sum / (y.center + x.center);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Computes the residual of the inner cells of a level.
+ *
+ * @details The residual is f - A u, where A u is minus the weighted second
+ * differences of u, divided by the spacing. Must be called by every thread
+ * of the team.
+ *
+ * @param level Level whose residual is computed.
+ */
+static void compute_residual(MultigridLevel* level) {
+  const Matrix* solution = level->solution;
+  const Matrix* rhs = level->rhs.buffer ? &level->rhs : NULL;
+  const uint64_t rows = solution->rows;
+  const uint64_t cols = solution->cols;
+  #pragma omp for schedule(static)
+  for (uint64_t i = 1; i < rows - 1; i++) {
+    const EdgeWeights y = i == rows - 2 ? level->last_row : kUniformWeights;
+    const double* up = matrix_row(solution, i - 1);
+    const double* row = matrix_row(solution, i);
+    const double* down = matrix_row(solution, i + 1);
+    const double* source = rhs ? matrix_row(rhs, i) : NULL;
+    double* residual = matrix_row(&level->residual, i);
+    for (uint64_t j = 1; j < cols - 1; j++) {
+      const EdgeWeights x = j == cols - 2 ? level->last_col : kUniformWeights;
+      const double laplacian = y.before * up[j] + y.after * down[j] +
+        x.before * row[j - 1] + x.after * row[j + 1] -
+        (y.center + x.center) * row[j];
+      residual[j] = (source ? source[j] : 0.0) + laplacian / level->spacing;
+    }
+  }
+}
+
+/**
+ * @brief Restricts the residual of a level to the right-hand side of the
+ * next one, with full weighting, and clears the correction of the next one.
+ *
+ * @param fine Level whose residual is restricted.
+ * @param coarse Next level.
+ */
+static void restrict_residual(const MultigridLevel* fine,
+  MultigridLevel* coarse) {
+  const Matrix* residual = &fine->residual;
+  const uint64_t rows = coarse->rhs.rows;
+  const uint64_t cols = coarse->rhs.cols;
+  #pragma omp for schedule(static)
+  for (uint64_t i = 1; i < rows - 1; i++) {
+    const double* up = matrix_row(residual, 2 * i - 1);
+    const double* row = matrix_row(residual, 2 * i);
+    const double* down = matrix_row(residual, 2 * i + 1);
+    double* rhs = matrix_row(&coarse->rhs, i);
+    double* correction = matrix_row(coarse->solution, i);
+    for (uint64_t j = 1; j < cols - 1; j++) {
+      const uint64_t k = 2 * j;
+      rhs[j] = (4.0 * row[k] + 2.0 * (up[k] + down[k] + row[k - 1] +
+        row[k + 1]) + up[k - 1] + up[k + 1] + down[k - 1] + down[k + 1]) /
+        16.0;
+      correction[j] = 0.0;
+    }
+  }
+}
+
+/**
+ * @brief Computes the weight of the previous coarse cell when interpolating
+ * a fine cell.
+ *
+ * @details Fine cells on a coarse cell take its value. Fine cells between
+ * two coarse cells take their average, except the last fine inner cell,
+ * which is closer to the coarse cell before it when the border is closer
+ * than one fine cell.
+ *
+ * @param index Index of the fine cell.
+ * @param last Index of the last fine inner cell.
+ * @param tail Distance from the last fine inner cell to the border.
+ * @return Weight of coarse cell index / 2; coarse cell (index + 1) / 2 gets
+ * the rest.
+ */
+static double interpolation_weight(uint64_t index, uint64_t last,
+  double tail) {
+  if (index % 2 == 0) {
+    return 1.0;
+  }
+  return index == last ? tail / (1.0 + tail) : 0.5;
+}
+
+/**
+ * @brief Adds the bilinear interpolation of the correction of the next level
+ * to the inner cells of a level.
+ *
+ * @param fine Level that receives the correction.
+ * @param coarse Next level.
+ */
+static void prolong_correction(MultigridLevel* fine,
+  const MultigridLevel* coarse) {
+  const Matrix* correction = coarse->solution;
+  const uint64_t rows = fine->solution->rows;
+  const uint64_t cols = fine->solution->cols;
+  #pragma omp for schedule(static)
+  for (uint64_t i = 1; i < rows - 1; i++) {
+    const double top_weight = interpolation_weight(i, rows - 2,
+      fine->row_tail);
+    const double* top = matrix_row(correction, i / 2);
+    const double* bottom = matrix_row(correction, (i + 1) / 2);
+    double* row = matrix_row(fine->solution, i);
+    for (uint64_t j = 1; j < cols - 1; j++) {
+      const double left_weight = interpolation_weight(j, cols - 2,
+        fine->col_tail);
+      const uint64_t left = j / 2;
+      const uint64_t right = (j + 1) / 2;
+      const double upper = left_weight * top[left] +
+        (1.0 - left_weight) * top[right];
+      const double lower = left_weight * bottom[left] +
+        (1.0 - left_weight) * bottom[right];
+      row[j] += top_weight * upper + (1.0 - top_weight) * lower;
+    }
+  }
+}
+
+/**
+ * @brief Runs one V-cycle from the given level down to the coarsest one.
+ *
+ * @details Must be called by every thread of the team.
+ *
+ * @param levels Levels of the hierarchy.
+ * @param level First level of the cycle.
+ * @param count Number of levels.
+ */
+static void v_cycle(MultigridLevel* levels, uint64_t level, uint64_t count) {
+  if (level == count - 1) {
+    smooth(&levels[level], MULTIGRID_COARSE_SWEEPS);
+    return;
+  }
+  smooth(&levels[level], MULTIGRID_PRE_SWEEPS);
+  compute_residual(&levels[level]);
+  restrict_residual(&levels[level], &levels[level + 1]);
+  v_cycle(levels, level + 1, count);
+  prolong_correction(&levels[level], &levels[level + 1]);
+  smooth(&levels[level], MULTIGRID_POST_SWEEPS);
+}
+
+/**
+ * @brief Solves the steady state of a plate with multigrid V-cycles.
+ *
+ * @details The steady state keeps the borders of the plate and makes every
+ * inner cell the average of its four neighbors, which is the plate the time
+ * stepping converges to. The plate is improved in place, one V-cycle with
+ * red-black Gauss-Seidel smoothing at a time, until the change that one more
+ * state of the time stepping would make to any cell, k * |4u - neighbors|,
+ * is smaller than epsilon. That change is the reported residual, so the
+ * resulting plate is at equilibrium under the same rule as the time
+ * stepping. A single team of threads runs every cycle, as in simulate().
+ * Gives up after MULTIGRID_MAX_CYCLES cycles. The resulting plate is written
+ * as plateNNN-steady.bin.
+ *
+ * @param shared_data Plate, parameters and epsilon of the job line.
+ * @param cycles Receives the number of V-cycles.
+ * @param residual Receives the residual of the resulting plate.
+ * @return EXIT_SUCCESS if the plate was solved, EXIT_FAILURE if memory could
+ * not be allocated.
+ */
+int solve_steady_state(SharedData* shared_data, uint64_t* cycles,
+  double* residual) {
+  *cycles = 0;
+  *residual = 0.0;
+  // Plates without inner cells are already at equilibrium.
+  MultigridLevel levels[MULTIGRID_MAX_LEVELS];
+  uint64_t count = 0;
+  if (shared_data->rows >= 3 && shared_data->cols >= 3) {
+    count = create_levels(levels, &shared_data->matrix);
+    if (count == 0) {
+      fprintf(stderr, "Could not allocate memory for multigrid levels.\n");
+      return EXIT_FAILURE;
+    }
+  }
+
+  const double delta = shared_data->delta;
+  const double h = shared_data->h;
+  const double factor = delta * shared_data->alpha / (h * h);
+  const Matrix* plate = &shared_data->matrix;
+  const uint64_t rows = plate->rows;
+  const uint64_t cols = plate->cols;
+
+  uint64_t cycle = 0;
+  bool done = count == 0;
+  double max_delta = 0.0;
+  #pragma omp parallel default(shared)
+  {
+    while (!done) {
+      // Largest change the next state of the time stepping would make.
+      #pragma omp for schedule(static) reduction(max:max_delta)
+      for (uint64_t i = 1; i < rows - 1; i++) {
+        const double* up = matrix_row(plate, i - 1);
+        const double* row = matrix_row(plate, i);
+        const double* down = matrix_row(plate, i + 1);
+        for (uint64_t j = 1; j < cols - 1; j++) {
+          const double change = fabs(factor * (up[j] + down[j] + row[j - 1] +
+            row[j + 1] - 4.0 * row[j]));
+          if (change > max_delta) {
+            max_delta = change;
+          }
+        }
+      }
+      #pragma omp single
+      {
+        *residual = max_delta;
+        max_delta = 0.0;
+        if (*residual < shared_data->epsilon ||
+          cycle == MULTIGRID_MAX_CYCLES) {
+          done = true;
+        } else {
+          cycle++;
+        }
+      }
+      if (!done) {
+        v_cycle(levels, 0, count);
+      }
+    }
+  }
+
+  if (*residual >= shared_data->epsilon) {
+    fprintf(stderr, "Multigrid did not reach epsilon for %s after %d "
+      "cycles.\n", shared_data->plate_filename, MULTIGRID_MAX_CYCLES);
+  }
+  *cycles = cycle;
+  destroy_levels(levels, count);
+
+  // The steady plate has no state number; it is named after the mode.
+  uint64_t plate_number = 0;
+  sscanf(shared_data->plate_filename, "plate%03lu.bin", &plate_number);
+  char path[MAX_PATH_LENGTH];
+  snprintf(path, sizeof(path), "%s/plate%03lu-steady.bin",
+    shared_data->output_dir, plate_number);
+  write_plate_file(path, &shared_data->matrix);
+  return EXIT_SUCCESS;
+}
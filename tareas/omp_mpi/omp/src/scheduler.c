@@ -0,0 +1,143 @@
+// Copyright 2024 Josue Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+#include "heat_simulation.h"
+
+/**
+ * @brief Estimated cost of a plate, used to order the simulations.
+ */
+typedef struct plate_cost {
+  double cost;     ///< Estimated work of the plate.
+  uint64_t index;  ///< Position of the plate in the job file.
+} PlateCost;
+
+/**
+ * @brief Estimates the cost of simulating a plate.
+ *
+ * @details Uses the number of cells, read in place from the mapped file
+ * header, and a rough estimate of the number of states: it grows with
+ * log(1 / epsilon) and shrinks with k = delta * alpha / (h * h), which sets
+ * how fast heat spreads. Multigrid needs a number of V-cycles that does
+ * not depend on the plate size, so k is ignored for steady-state lines.
+ * It is only used for ordering, so it does not need to be accurate.
+ *
+ * @param params Parameters of the plate.
+ * @param input_dir Directory where the binary file is located.
+ * @return Estimated cost; 0 if the header could not be read.
+ */
+static double estimate_cost(const SimData* params, const char* input_dir) {
+  char bin_path[MAX_PATH_LENGTH];
+  snprintf(bin_path, sizeof(bin_path), "%s/%s", input_dir, params->bin_name);
+  PlateMap plate_map;
+  if (plate_map_open(&plate_map, bin_path) != EXIT_SUCCESS) {
+    return 0.0;
+  }
+  double cost = (double) plate_map.rows * (double) plate_map.cols;
+  plate_map_close(&plate_map);
+  if (params->epsilon > 0.0 && params->epsilon < 1.0) {
+    cost *= 1.0 - log(params->epsilon);
+  }
+  const double k = params->delta * params->alpha /
+    ((double) params->h * params->h);
+  if (k > 0.0 && !params->steady) {
+    cost /= k;
+  }
+  return cost;
+}
+
+/**
+ * @brief Orders plates from the most to the least expensive.
+ *
+ * @details Plates with the same cost keep the job file order.
+ */
+static int compare_costs(const void* first, const void* second) {
+  const PlateCost* a = (const PlateCost*) first;
+  const PlateCost* b = (const PlateCost*) second;
+  if (a->cost != b->cost) {
+    return a->cost < b->cost ? 1 : -1;
+  }
+  return a->index < b->index ? -1 : a->index > b->index;
+}
+
+/**
+ * @brief Simulates all the plates of a job concurrently.
+ *
+ * @details Job lines that only differ in epsilon are grouped and simulated
+ * once. The threads are split between plate-level and intra-plate
+ * parallelism: up to one group runs per thread, and the threads left over
+ * when the job has fewer groups than threads go to the most expensive groups.
+ * Groups are dispatched dynamically from the most to the least expensive, so
+ * long plates start first and small plates fill the gaps at the end. Results
+ * are stored by job file position so the report keeps that order.
+ *
+ * @param params Parameters of every line of the job file.
+ * @param count Number of lines in the job file.
+ * @param input_dir Directory with the binary files.
+ * @param thread_count Number of threads available for the whole job.
+ * @param tasks Step the plates with the task engine.
+ * @param states Receives the number of states of every plate.
+ * @param residuals Receives the residual of every steady-state line.
+ * @param results Receives EXIT_SUCCESS for every plate that was simulated.
+ */
+void schedule_job(const SimData* params, uint64_t count, const char* input_dir,
+  uint64_t thread_count, bool tasks, uint64_t* states, double* residuals,
+  int* results) {
+  for (uint64_t i = 0; i < count; i++) {
+    results[i] = EXIT_FAILURE;
+  }
+  if (count == 0) {
+    return;
+  }
+  uint64_t* lines = (uint64_t*) calloc(count, sizeof(uint64_t));
+  uint64_t group_count = 0;
+  SimGroup* groups = lines ?
+    group_job_lines(params, count, lines, &group_count) : NULL;
+  PlateCost* costs = (PlateCost*) calloc(count, sizeof(PlateCost));
+  if (!lines || !groups || !costs) {
+    fprintf(stderr, "Could not allocate memory for job scheduler.\n");
+    free(lines);
+    free(groups);
+    free(costs);
+    return;
+  }
+  // Every line was malformed, so there is nothing to simulate.
+  if (group_count == 0) {
+    free(costs);
+    free(groups);
+    free(lines);
+    return;
+  }
+
+  // Order the groups from the most to the least expensive. A group costs as
+  // much as its smallest epsilon.
+  for (uint64_t i = 0; i < group_count; i++) {
+    costs[i].cost = estimate_cost(&groups[i].params, input_dir);
+    costs[i].index = i;
+  }
+  qsort(costs, group_count, sizeof(PlateCost), compare_costs);
+
+  // Split the threads between groups and the threads of each group.
+  const uint64_t plate_workers = thread_count < group_count ?
+    thread_count : group_count;
+  const uint64_t threads_per_plate = thread_count / plate_workers;
+  const uint64_t extra_threads = thread_count % plate_workers;
+
+  // With OMP_PLACES set, every plate gets its own share of the places, so the
+  // threads of concurrent plates do not pile up on the same cores.
+  omp_set_max_active_levels(2);
+  #pragma omp parallel for num_threads(plate_workers) schedule(dynamic, 1) \
+    proc_bind(spread)
+  for (uint64_t position = 0; position < group_count; position++) {
+    const SimGroup* group = &groups[costs[position].index];
+    const uint64_t plate_threads = threads_per_plate +
+      (position < extra_threads ? 1 : 0);
+    const int result = configure_simulation(params, group, input_dir,
+      plate_threads, tasks, states, residuals);
+    for (uint64_t i = 0; i < group->count; i++) {
+      results[group->lines[i]] = result;
+    }
+  }
+
+  free(costs);
+  free(groups);
+  free(lines);
+}
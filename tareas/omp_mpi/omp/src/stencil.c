@@ -0,0 +1,175 @@
+// Copyright 2024 Josué Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+#include <math.h>
+
+#include "stencil.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STENCIL_X86
+#endif
+
+/**
+ * @brief Scalar reference kernel.
+ *
+ * @details Defines the order of operations the vector kernels must follow to
+ * produce exactly the same results.
+ *
+ * @param up Row above.
+ * @param row Row to update.
+ * @param down Row below.
+ * @param next Row that receives the next state.
+ * @param cols Number of columns in the plate.
+ * @param k Constant delta * alpha / (h * h).
+ * @return Largest absolute temperature change in the row.
+ */
+double stencil_row_scalar(const double* up, const double* row,
+  const double* down, double* next, uint64_t cols, double k) {
+  double max_delta = 0.0;
+  for (uint64_t j = 1; j < cols - 1; j++) {
+    double cell = row[j];
+    double cells_around = up[j] + row[j + 1] + down[j] + row[j - 1];
+    double value = cell + k * (cells_around - 4 * cell);
+    next[j] = value;
+    double delta = fabs(value - cell);
+    if (delta > max_delta) {
+      max_delta = delta;
+    }
+  }
+  return max_delta;
+}
+
+#ifdef STENCIL_X86
+// Compute the columns that do not fill a vector with the scalar kernel.
+static double stencil_tail(const double* up, const double* row,
+  const double* down, double* next, uint64_t cols, double k, uint64_t first,
+  double max_delta) {
+  // The scalar kernel handles columns first to cols - 2.
+  double tail_delta = stencil_row_scalar(up + first - 1, row + first - 1,
+    down + first - 1, next + first - 1, cols - first + 1, k);
+  return tail_delta > max_delta ? tail_delta : max_delta;
+}
+
+// SSE2 kernel: two cells per instruction.
+__attribute__((target("sse2")))
+static double stencil_row_sse2(const double* up, const double* row,
+  const double* down, double* next, uint64_t cols, double k) {
+  const __m128d vk = _mm_set1_pd(k);
+  const __m128d four = _mm_set1_pd(4.0);
+  const __m128d sign = _mm_set1_pd(-0.0);
+  __m128d vmax = _mm_setzero_pd();
+  uint64_t j = 1;
+  for (; j + 2 <= cols - 1; j += 2) {
+    __m128d cell = _mm_loadu_pd(row + j);
+    __m128d up_cell = _mm_loadu_pd(up + j);
+    __m128d down_cell = _mm_loadu_pd(down + j);
+    __m128d left = _mm_loadu_pd(row + j - 1);
+    __m128d right = _mm_loadu_pd(row + j + 1);
+    __m128d cells_around = _mm_add_pd(up_cell, right);
+    cells_around = _mm_add_pd(cells_around, down_cell);
+    cells_around = _mm_add_pd(cells_around, left);
+    __m128d value = _mm_add_pd(cell, _mm_mul_pd(vk,
+      _mm_sub_pd(cells_around, _mm_mul_pd(four, cell))));
+    _mm_storeu_pd(next + j, value);
+    vmax = _mm_max_pd(vmax, _mm_andnot_pd(sign, _mm_sub_pd(value, cell)));
+  }
+  // Reduce the lanes to the maximum of the row.
+  vmax = _mm_max_pd(vmax, _mm_unpackhi_pd(vmax, vmax));
+  return stencil_tail(up, row, down, next, cols, k, j, _mm_cvtsd_f64(vmax));
+}
+
+// AVX2 kernel with FMA: four cells per instruction.
+__attribute__((target("avx2,fma")))
+static double stencil_row_avx2(const double* up, const double* row,
+  const double* down, double* next, uint64_t cols, double k) {
+  const __m256d vk = _mm256_set1_pd(k);
+  const __m256d four = _mm256_set1_pd(4.0);
+  const __m256d sign = _mm256_set1_pd(-0.0);
+  __m256d vmax = _mm256_setzero_pd();
+  uint64_t j = 1;
+  for (; j + 4 <= cols - 1; j += 4) {
+    __m256d cell = _mm256_loadu_pd(row + j);
+    __m256d up_cell = _mm256_loadu_pd(up + j);
+    __m256d down_cell = _mm256_loadu_pd(down + j);
+    __m256d left = _mm256_loadu_pd(row + j - 1);
+    __m256d right = _mm256_loadu_pd(row + j + 1);
+    __m256d cells_around = _mm256_add_pd(up_cell, right);
+    cells_around = _mm256_add_pd(cells_around, down_cell);
+    cells_around = _mm256_add_pd(cells_around, left);
+    __m256d value = _mm256_add_pd(cell, _mm256_mul_pd(vk,
+      _mm256_fnmadd_pd(four, cell, cells_around)));
+    _mm256_storeu_pd(next + j, value);
+    vmax = _mm256_max_pd(vmax, _mm256_andnot_pd(sign,
+      _mm256_sub_pd(value, cell)));
+  }
+  // Reduce the lanes to the maximum of the row.
+  __m128d half = _mm_max_pd(_mm256_castpd256_pd128(vmax),
+    _mm256_extractf128_pd(vmax, 1));
+  half = _mm_max_pd(half, _mm_unpackhi_pd(half, half));
+  return stencil_tail(up, row, down, next, cols, k, j, _mm_cvtsd_f64(half));
+}
+
+// AVX-512 kernel: eight cells per instruction.
+__attribute__((target("avx512f")))
+static double stencil_row_avx512(const double* up, const double* row,
+  const double* down, double* next, uint64_t cols, double k) {
+  const __m512d vk = _mm512_set1_pd(k);
+  const __m512d four = _mm512_set1_pd(4.0);
+  __m512d vmax = _mm512_setzero_pd();
+  uint64_t j = 1;
+  for (; j + 8 <= cols - 1; j += 8) {
+    __m512d cell = _mm512_loadu_pd(row + j);
+    __m512d up_cell = _mm512_loadu_pd(up + j);
+    __m512d down_cell = _mm512_loadu_pd(down + j);
+    __m512d left = _mm512_loadu_pd(row + j - 1);
+    __m512d right = _mm512_loadu_pd(row + j + 1);
+    __m512d cells_around = _mm512_add_pd(up_cell, right);
+    cells_around = _mm512_add_pd(cells_around, down_cell);
+    cells_around = _mm512_add_pd(cells_around, left);
+    __m512d value = _mm512_add_pd(cell, _mm512_mul_pd(vk,
+      _mm512_fnmadd_pd(four, cell, cells_around)));
+    _mm512_storeu_pd(next + j, value);
+    vmax = _mm512_max_pd(vmax, _mm512_abs_pd(_mm512_sub_pd(value, cell)));
+  }
+  return stencil_tail(up, row, down, next, cols, k, j,
+    _mm512_reduce_max_pd(vmax));
+}
+#endif
+
+// Selected kernel; the scalar one until stencil_init() is called.
+static StencilKernel stencil_kernel = stencil_row_scalar;
+
+/**
+ * @brief Selects the widest kernel supported by the CPU.
+ *
+ * @details Queries cpuid through __builtin_cpu_supports. Must be called once
+ * at program startup, before any threads are created.
+ */
+void stencil_init(void) {
+#ifdef STENCIL_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    stencil_kernel = stencil_row_avx512;
+  } else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    stencil_kernel = stencil_row_avx2;
+  } else if (__builtin_cpu_supports("sse2")) {
+    stencil_kernel = stencil_row_sse2;
+  }
+#endif
+}
+
+/**
+ * @brief Computes one row of the next state with the selected kernel.
+ *
+ * @param up Row above.
+ * @param row Row to update.
+ * @param down Row below.
+ * @param next Row that receives the next state.
+ * @param cols Number of columns in the plate.
+ * @param k Constant delta * alpha / (h * h).
+ * @return Largest absolute temperature change in the row.
+ */
+double stencil_row(const double* up, const double* row, const double* down,
+  double* next, uint64_t cols, double k) {
+  return stencil_kernel(up, row, down, next, cols, k);
+}
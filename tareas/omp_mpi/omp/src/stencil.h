@@ -0,0 +1,35 @@
+// Copyright 2024 Josué Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+#ifndef STENCIL_H
+#define STENCIL_H
+
+#include <stdint.h>
+
+/**
+ * @brief Kernel that computes one row of the next plate state.
+ *
+ * @details Computes columns 1 to cols - 2 of 'next' from 'row' and its
+ * neighbors 'up' and 'down', where k = delta * alpha / (h * h). Returns the
+ * largest absolute temperature change within the row.
+ */
+typedef double (*StencilKernel)(const double* up, const double* row,
+  const double* down, double* next, uint64_t cols, double k);
+
+// The vector kernels (SSE2, AVX2+FMA and AVX-512) match the scalar kernel bit
+// for bit, i.e. the documented tolerance is 0: every lane performs the same
+// operations in the same order as the scalar code. FMA is only used to
+// subtract 4 * cell, a product that is always exact; using it for the final
+// update would change the last bit and therefore the results.
+
+// Selects the kernel according to the CPU capabilities.
+void stencil_init(void);
+
+// Computes one row with the kernel selected by stencil_init().
+double stencil_row(const double* up, const double* row, const double* down,
+  double* next, uint64_t cols, double k);
+
+// Scalar reference kernel.
+double stencil_row_scalar(const double* up, const double* row,
+  const double* down, double* next, uint64_t cols, double k);
+
+#endif  // STENCIL_H
@@ -0,0 +1,193 @@
+// Copyright 2024 Josue Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+#include <stdatomic.h>
+
+#include "heat_simulation.h"
+
+/**
+ * @brief State of the task engine, shared by all the tasks of a plate.
+ */
+typedef struct task_engine {
+  SharedData* shared_data;  ///< Plate, epsilons and output settings.
+  Matrix buffers[TASK_LOOKAHEAD];  ///< State t lives in buffers[t % L].
+  uint64_t bands;           ///< Number of row bands of the plate.
+  double factor;            ///< Constant delta * alpha / (h * h).
+  /// Largest change of the states in the ring. Changes are never negative,
+  /// and non-negative doubles order like their bits, so they are kept as bits.
+  _Atomic uint64_t max_bits[TASK_LOOKAHEAD];
+  atomic_bool done;         ///< Every epsilon reached equilibrium.
+  uint64_t states;          ///< State of the last equilibrium.
+  char checks;              ///< Keeps the check tasks in state order.
+  char windows[TASK_LOOKAHEAD];  ///< Check of state t is windows[t % L].
+} TaskEngine;
+
+/**
+ * @brief Computes one state of one band of rows.
+ *
+ * @details Reads state - 1 and writes state, and folds the largest change of
+ * the band into the accumulator of the state with a compare-and-swap loop.
+ * Tasks that start after the last equilibrium do nothing.
+ *
+ * @param engine Task engine of the plate.
+ * @param band Band to compute.
+ * @param state State to compute.
+ */
+static void step_band(TaskEngine* engine, uint64_t band, uint64_t state) {
+  if (atomic_load_explicit(&engine->done, memory_order_relaxed)) {
+    return;
+  }
+  const Matrix* matrix = &engine->buffers[(state - 1) % TASK_LOOKAHEAD];
+  const Matrix* next_matrix = &engine->buffers[state % TASK_LOOKAHEAD];
+  const uint64_t rows = matrix->rows;
+  const uint64_t inner = rows > 2 ? rows - 2 : 0;
+  const uint64_t first_row = 1 + inner * band / engine->bands;
+  const uint64_t last_row = 1 + inner * (band + 1) / engine->bands;
+
+  double band_delta = 0.0;
+  for (uint64_t i = first_row; i < last_row; i++) {
+    const double row_delta = stencil_row(matrix_row(matrix, i - 1),
+      matrix_row(matrix, i), matrix_row(matrix, i + 1),
+      matrix_row(next_matrix, i), matrix->cols, engine->factor);
+    if (row_delta > band_delta) {
+      band_delta = row_delta;
+    }
+  }
+
+  uint64_t bits = 0;
+  memcpy(&bits, &band_delta, sizeof(bits));
+  _Atomic uint64_t* max_bits = &engine->max_bits[state % TASK_LOOKAHEAD];
+  uint64_t seen = atomic_load_explicit(max_bits, memory_order_relaxed);
+  while (bits > seen && !atomic_compare_exchange_weak_explicit(max_bits,
+    &seen, bits, memory_order_relaxed, memory_order_relaxed)) {
+  }
+}
+
+/**
+ * @brief Checks the epsilons against a state once all its bands are done.
+ *
+ * @details Runs after every band of the state and before any band of
+ * state + TASK_LOOKAHEAD, which is written into the same buffer, so the state
+ * is complete and intact while its plate is written. Checks run in state
+ * order. The accumulator is cleared for state + TASK_LOOKAHEAD.
+ *
+ * @param engine Task engine of the plate.
+ * @param state State to check.
+ */
+static void check_state(TaskEngine* engine, uint64_t state) {
+  const uint64_t bits = atomic_exchange_explicit(
+    &engine->max_bits[state % TASK_LOOKAHEAD], 0, memory_order_relaxed);
+  if (atomic_load_explicit(&engine->done, memory_order_relaxed)) {
+    return;
+  }
+  double max_delta = 0.0;
+  memcpy(&max_delta, &bits, sizeof(max_delta));
+  SharedData* shared_data = engine->shared_data;
+  if (max_delta < shared_data->epsilon) {
+    shared_data->matrix = engine->buffers[state % TASK_LOOKAHEAD];
+    if (record_equilibrium(shared_data, state, max_delta)) {
+      engine->states = state;
+      atomic_store_explicit(&engine->done, true, memory_order_relaxed);
+    }
+  }
+}
+
+/**
+ * @brief Simulates heat diffusion with a graph of OpenMP tasks.
+ *
+ * @details The inner rows are split in TASK_BANDS_PER_THREAD bands per
+ * thread. State t of a band is a task that depends only on state t - 1 of
+ * itself and of the bands above and below, so a band runs ahead as soon as
+ * its neighbors are done and no thread waits for the slowest one at every
+ * state. The states rotate through a ring of TASK_LOOKAHEAD buffers, and
+ * dependencies are expressed on one sentinel per band and buffer. A check
+ * task per state depends on all its bands and compares the largest change
+ * against the epsilons; since it reads the state, only the bands of
+ * state t + TASK_LOOKAHEAD, which overwrite that buffer, wait for it. Bands
+ * therefore run up to TASK_LOOKAHEAD - 1 states ahead of the last check, and
+ * one thread generates the tasks at most that far ahead. The kernel and its
+ * inputs are the same as in simulate(), so the states and plates are
+ * identical.
+ *
+ * @param states Receives the number of states until the last equilibrium.
+ * @param shared_data Plate, parameters and epsilons of the simulation.
+ */
+void simulate_tasks(uint64_t* states, SharedData* shared_data) {
+  TaskEngine engine;
+  memset(&engine, 0, sizeof(engine));
+  engine.shared_data = shared_data;
+  engine.factor = (double) shared_data->delta * shared_data->alpha /
+    ((double) shared_data->h * shared_data->h);
+  const uint64_t rows = shared_data->rows;
+  const uint64_t inner = rows > 2 ? rows - 2 : 0;
+  engine.bands = (uint64_t) omp_get_max_threads() * TASK_BANDS_PER_THREAD;
+  if (engine.bands > inner) {
+    engine.bands = inner ? inner : 1;
+  }
+  for (int i = 0; i < TASK_LOOKAHEAD; i++) {
+    atomic_init(&engine.max_bits[i], 0);
+  }
+  atomic_init(&engine.done, false);
+
+  // Borders never change, so every buffer of the ring gets them once.
+  engine.buffers[0] = shared_data->matrix;
+  char (*sentinels)[TASK_LOOKAHEAD] = (char (*)[TASK_LOOKAHEAD]) calloc(
+    engine.bands, sizeof(char[TASK_LOOKAHEAD]));
+  bool allocated = sentinels != NULL;
+  for (int i = 1; i < TASK_LOOKAHEAD && allocated; i++) {
+    allocated = matrix_create(&engine.buffers[i], rows, shared_data->cols) ==
+      EXIT_SUCCESS;
+    if (allocated) {
+      memcpy(engine.buffers[i].buffer, engine.buffers[0].buffer,
+        rows * engine.buffers[0].stride * sizeof(double));
+    }
+  }
+  if (!allocated) {
+    fprintf(stderr, "Could not allocate memory for matrix copies.\n");
+    for (int i = 1; i < TASK_LOOKAHEAD; i++) {
+      matrix_destroy(&engine.buffers[i]);
+    }
+    free(sentinels);
+    return;
+  }
+
+  const uint64_t bands = engine.bands;
+  #pragma omp parallel
+  #pragma omp single
+  {
+    for (uint64_t state = 1; !atomic_load(&engine.done); state++) {
+      const uint64_t read = (state - 1) % TASK_LOOKAHEAD;
+      const uint64_t write = state % TASK_LOOKAHEAD;
+      const uint64_t window = write;
+      if (state > TASK_LOOKAHEAD) {
+        // Run tasks until the check of state - TASK_LOOKAHEAD is done.
+        #pragma omp taskwait depend(in: engine.windows[window])
+        if (atomic_load(&engine.done)) {
+          break;
+        }
+      }
+      for (uint64_t band = 0; band < bands; band++) {
+        // Bands on the borders repeat their own sentinel.
+        const uint64_t above = band > 0 ? band - 1 : band;
+        const uint64_t below = band + 1 < bands ? band + 1 : band;
+        #pragma omp task firstprivate(band, state) \
+          depend(in: sentinels[above][read], sentinels[band][read]) \
+          depend(in: sentinels[below][read]) \
+          depend(out: sentinels[band][write])
+        step_band(&engine, band, state);
+      }
+      #pragma omp task firstprivate(state) \
+        depend(iterator(b = 0:bands), in: sentinels[b][write]) \
+        depend(inout: engine.checks) depend(out: engine.windows[window])
+      check_state(&engine, state);
+    }
+  }
+
+  *states = engine.states;
+  // The plate of the last equilibrium stays in shared_data->matrix.
+  for (int i = 0; i < TASK_LOOKAHEAD; i++) {
+    if (engine.buffers[i].buffer != shared_data->matrix.buffer) {
+      matrix_destroy(&engine.buffers[i]);
+    }
+  }
+  free(sentinels);
+}
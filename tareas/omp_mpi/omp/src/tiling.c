@@ -0,0 +1,297 @@
+// Copyright 2024 Josue Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+#include "heat_simulation.h"
+
+/**
+ * @brief Geometry of the tiles that cover the interior of the plate.
+ */
+typedef struct tiling {
+  uint64_t tile_rows;   ///< Rows owned by each tile.
+  uint64_t tile_cols;   ///< Columns owned by each tile.
+  uint64_t tiles_per_row;  ///< Number of tiles across the plate.
+  uint64_t tile_count;  ///< Total number of tiles.
+} Tiling;
+
+/**
+ * @brief Computes columns [first_col, last_col) of one row of a tile.
+ *
+ * @details Scratch rows store the plate columns starting at 'col_base', so
+ * plate column j lives at local index j - col_base.
+ *
+ * @return Largest absolute change in the computed columns.
+ */
+static double advance_segment(const double* up, const double* row,
+  const double* down, double* next, uint64_t col_base, uint64_t first_col,
+  uint64_t last_col, double factor) {
+  if (last_col <= first_col) {
+    return 0.0;
+  }
+  const uint64_t offset = first_col - col_base - 1;
+  return stencil_row(up + offset, row + offset, down + offset, next + offset,
+    last_col - first_col + 2, factor);
+}
+
+/**
+ * @brief Advances one tile several states using overlapped tiling.
+ *
+ * @details The tile owns rows [first_row, last_row) and columns [first_col,
+ * last_col). To advance it 'steps' states without talking to other tiles, it
+ * copies a halo of 'steps' cells on each side into the scratch buffers, which
+ * are small enough to stay in cache. After every state the valid region
+ * shrinks by one cell per side, except at the plate borders, which never
+ * change. Every cell is computed by the same kernel and from the same inputs
+ * as in the step-by-step engine, so the results are identical.
+ *
+ * @param matrix Plate at the beginning of the block; it is only read.
+ * @param next_matrix Plate that receives the owned cells after 'steps' states.
+ * @param scratch Two scratch matrices with room for the tile and its halo.
+ * @param first_row First row owned by the tile.
+ * @param last_row Row after the last one owned by the tile.
+ * @param first_col First column owned by the tile.
+ * @param last_col Column after the last one owned by the tile.
+ * @param steps Number of states to advance.
+ * @param factor Constant delta * alpha / (h * h).
+ * @param tile_deltas Receives the largest change of the owned cells after
+ * each state.
+ */
+static void advance_tile(const Matrix* matrix, const Matrix* next_matrix,
+  Matrix scratch[2], uint64_t first_row, uint64_t last_row, uint64_t first_col,
+  uint64_t last_col, uint64_t steps, double factor, double* tile_deltas) {
+  const uint64_t rows = matrix->rows;
+  const uint64_t cols = matrix->cols;
+  // Cells that can influence the tile within 'steps' states.
+  const uint64_t row_base = first_row > steps ? first_row - steps : 0;
+  const uint64_t row_top = last_row + steps < rows ? last_row + steps : rows;
+  const uint64_t col_base = first_col > steps ? first_col - steps : 0;
+  const uint64_t col_top = last_col + steps < cols ? last_col + steps : cols;
+
+  // Load the tile and its halo. The second buffer only needs the plate
+  // borders, because every other cell is written before it is read.
+  const uint64_t width = col_top - col_base;
+  for (uint64_t i = row_base; i < row_top; i++) {
+    const double* source = matrix_row(matrix, i) + col_base;
+    double* target = matrix_row(&scratch[1], i - row_base);
+    memcpy(matrix_row(&scratch[0], i - row_base), source,
+      width * sizeof(double));
+    if (i == 0 || i == rows - 1) {
+      memcpy(target, source, width * sizeof(double));
+    }
+    if (col_base == 0) {
+      target[0] = source[0];
+    }
+    if (col_top == cols) {
+      target[width - 1] = source[width - 1];
+    }
+  }
+
+  const Matrix* current = &scratch[0];
+  const Matrix* next = &scratch[1];
+  for (uint64_t step = 1; step <= steps; step++) {
+    // Cells that are still exact after this state.
+    uint64_t low_row = first_row + step > steps ? first_row + step - steps : 0;
+    uint64_t high_row = last_row + steps - step;
+    uint64_t low_col = first_col + step > steps ? first_col + step - steps : 0;
+    uint64_t high_col = last_col + steps - step;
+    low_row = low_row < 1 ? 1 : low_row;
+    high_row = high_row > rows - 1 ? rows - 1 : high_row;
+    low_col = low_col < 1 ? 1 : low_col;
+    high_col = high_col > cols - 1 ? cols - 1 : high_col;
+
+    double tile_delta = 0.0;
+    for (uint64_t i = low_row; i < high_row; i++) {
+      const uint64_t local = i - row_base;
+      const double* up = matrix_row(current, local - 1);
+      const double* row = matrix_row(current, local);
+      const double* down = matrix_row(current, local + 1);
+      double* next_row = matrix_row(next, local);
+      // Halo cells are owned by other tiles, so their changes do not count.
+      advance_segment(up, row, down, next_row, col_base, low_col, first_col,
+        factor);
+      advance_segment(up, row, down, next_row, col_base, last_col, high_col,
+        factor);
+      double delta = advance_segment(up, row, down, next_row, col_base,
+        first_col, last_col, factor);
+      if (i >= first_row && i < last_row && delta > tile_delta) {
+        tile_delta = delta;
+      }
+    }
+    tile_deltas[step - 1] = tile_delta;
+
+    const Matrix* temp = current;
+    current = next;
+    next = temp;
+  }
+
+  // Publish the owned cells of the last state.
+  for (uint64_t i = first_row; i < last_row; i++) {
+    memcpy(matrix_row(next_matrix, i) + first_col,
+      matrix_row(current, i - row_base) + first_col - col_base,
+      (last_col - first_col) * sizeof(double));
+  }
+}
+
+/**
+ * @brief Advances every tile of the plate the same number of states.
+ *
+ * @details Tiles are independent within a block, so they are distributed
+ * dynamically among the OpenMP threads. Each thread uses its own pair of
+ * scratch matrices.
+ *
+ * @param shared_data Plate and simulation parameters.
+ * @param next_matrix Plate that receives the state after the block.
+ * @param scratch Two scratch matrices per thread.
+ * @param tiling Geometry of the tiles.
+ * @param steps Number of states to advance.
+ * @param factor Constant delta * alpha / (h * h).
+ * @param tile_deltas Per tile and state largest change, 'TILING_STEPS' values
+ * per tile.
+ */
+static void advance_block(const SharedData* shared_data,
+  const Matrix* next_matrix, Matrix* scratch, const Tiling* tiling,
+  uint64_t steps, double factor, double* tile_deltas) {
+  const uint64_t rows = shared_data->rows;
+  const uint64_t cols = shared_data->cols;
+
+  #pragma omp parallel for schedule(dynamic)
+  for (uint64_t tile = 0; tile < tiling->tile_count; tile++) {
+    const uint64_t first_row = 1 + tile / tiling->tiles_per_row *
+      tiling->tile_rows;
+    const uint64_t first_col = 1 + tile % tiling->tiles_per_row *
+      tiling->tile_cols;
+    const uint64_t last_row = first_row + tiling->tile_rows < rows - 1 ?
+      first_row + tiling->tile_rows : rows - 1;
+    const uint64_t last_col = first_col + tiling->tile_cols < cols - 1 ?
+      first_col + tiling->tile_cols : cols - 1;
+    advance_tile(&shared_data->matrix, next_matrix,
+      &scratch[2 * omp_get_thread_num()], first_row, last_row, first_col,
+      last_col, steps, factor, &tile_deltas[tile * TILING_STEPS]);
+  }
+}
+
+/**
+ * @brief Simulates heat diffusion with temporal blocking.
+ *
+ * @details The plate is split into overlapped tiles sized so that the two
+ * scratch buffers of a tile, halo included, fit in 'TILING_CACHE_BYTES'. Each
+ * tile is advanced 'TILING_STEPS' states before moving on, so the plate is
+ * streamed from memory once per block instead of once per state. Each tile
+ * records the largest change of its cells after every state; the first state
+ * where no tile reaches epsilon is the exact equilibrium state. If it falls
+ * inside a block, the block is recomputed from its unchanged input up to that
+ * state, so both the state count and the final plate match 'simulate'. The
+ * following epsilons of the group continue from there.
+ *
+ * @param states Pointer to store the number of iterations required to reach
+ * equilibrium.
+ * @param shared_data Pointer to a SharedData structure containing matrix data,
+ * dimensions, and thermal properties for the simulation.
+ */
+void simulate_tiled(uint64_t* states, SharedData* shared_data) {
+  const uint64_t rows = shared_data->rows;
+  const uint64_t cols = shared_data->cols;
+  const uint64_t steps = TILING_STEPS;
+  const double delta = shared_data->delta;
+  const double h = shared_data->h;
+  const double factor = delta * shared_data->alpha / (h * h);
+
+  // Size the tiles so both scratch buffers, halo included, fit in the cache
+  // budget. Tiles are square unless the plate is narrower than a tile.
+  const uint64_t interior_rows = rows > 2 ? rows - 2 : 0;
+  const uint64_t interior_cols = cols > 2 ? cols - 2 : 0;
+  const uint64_t side = (uint64_t) sqrt(TILING_CACHE_BYTES /
+    (2.0 * sizeof(double)));
+  Tiling tiling;
+  tiling.tile_cols = side > 3 * steps ? side - 2 * steps : steps;
+  if (tiling.tile_cols > interior_cols) {
+    tiling.tile_cols = interior_cols ? interior_cols : 1;
+  }
+  tiling.tile_rows = TILING_CACHE_BYTES / (2 * sizeof(double) *
+    (tiling.tile_cols + 2 * steps));
+  tiling.tile_rows = tiling.tile_rows > 3 * steps ?
+    tiling.tile_rows - 2 * steps : steps;
+  tiling.tiles_per_row = (interior_cols + tiling.tile_cols - 1) /
+    tiling.tile_cols;
+  tiling.tile_count = tiling.tiles_per_row * ((interior_rows +
+    tiling.tile_rows - 1) / tiling.tile_rows);
+
+  // Buffer for the next state. Borders never change, so they are copied once.
+  Matrix next_matrix;
+  if (matrix_create(&next_matrix, rows, cols) != EXIT_SUCCESS) {
+    fprintf(stderr, "Could not allocate memory for matrix copy.\n");
+    return;
+  }
+  memcpy(next_matrix.buffer, shared_data->matrix.buffer,
+    rows * shared_data->matrix.stride * sizeof(double));
+
+  // Scratch buffers, allocated once per thread for the whole simulation.
+  const uint64_t thread_count = omp_get_max_threads();
+  Matrix* scratch = (Matrix*) calloc(2 * thread_count, sizeof(Matrix));
+  double* tile_deltas = (double*) malloc((tiling.tile_count ?
+    tiling.tile_count : 1) * steps * sizeof(double));
+  bool allocated = scratch && tile_deltas;
+  for (uint64_t i = 0; allocated && i < 2 * thread_count; i++) {
+    allocated = matrix_create(&scratch[i], tiling.tile_rows + 2 * steps,
+      tiling.tile_cols + 2 * steps) == EXIT_SUCCESS;
+  }
+
+  uint64_t state = 0;
+  bool finished = !allocated;
+  if (!allocated) {
+    fprintf(stderr, "Could not allocate memory for tiles.\n");
+  }
+
+  while (!finished) {
+    advance_block(shared_data, &next_matrix, scratch, &tiling, steps, factor,
+      tile_deltas);
+
+    // Find the first state of the block where every tile is under epsilon.
+    uint64_t block_steps = steps;
+    bool equilibrium = false;
+    for (uint64_t step = 0; step < steps && !equilibrium; step++) {
+      equilibrium = true;
+      for (uint64_t tile = 0; tile < tiling.tile_count; tile++) {
+        if (tile_deltas[tile * steps + step] >= shared_data->epsilon) {
+          equilibrium = false;
+          break;
+        }
+      }
+      if (equilibrium) {
+        block_steps = step + 1;
+      }
+    }
+
+    // Equilibrium inside the block: redo it up to that state.
+    if (block_steps < steps) {
+      advance_block(shared_data, &next_matrix, scratch, &tiling, block_steps,
+        factor, tile_deltas);
+    }
+    state += block_steps;
+
+    // Swap buffers: the new state becomes the current one.
+    Matrix temp = shared_data->matrix;
+    shared_data->matrix = next_matrix;
+    next_matrix = temp;
+
+    // Record every epsilon that reached equilibrium in the last state; the
+    // next block aims at the following one.
+    if (equilibrium) {
+      double max_delta = 0.0;
+      for (uint64_t tile = 0; tile < tiling.tile_count; tile++) {
+        if (tile_deltas[tile * steps + block_steps - 1] > max_delta) {
+          max_delta = tile_deltas[tile * steps + block_steps - 1];
+        }
+      }
+      finished = record_equilibrium(shared_data, state, max_delta);
+    }
+  }
+
+  *states = state;
+
+  // Free memory.
+  for (uint64_t i = 0; scratch && i < 2 * thread_count; i++) {
+    matrix_destroy(&scratch[i]);
+  }
+  free(scratch);
+  free(tile_deltas);
+  matrix_destroy(&next_matrix);
+}
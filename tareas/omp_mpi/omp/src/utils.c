@@ -29,6 +29,11 @@ uint64_t count_job_lines(FILE* bin_name) {
 /**
  * @brief Reads the contents of the job file and returns its parameters.
  *
+ * @details Each line holds the plate file, delta, alpha, h and epsilon. An
+ * optional sixth field "multigrid" asks for the steady state of the plate
+ * instead of the time stepping. A line with missing fields or an unknown
+ * sixth field is reported and marked as malformed, so it is not simulated.
+ *
  * @param job_file Name of the job file to read.
  * @param struct_count Pointer to store the number of structures.
  * @return Structure containing the contents of the job file.
@@ -53,22 +58,98 @@ SimData* read_job_file(const char* job_file, uint64_t* struct_count) {
   for (uint64_t line_number = 0; line_number < lines_in_txt; ++line_number) {
     if (fgets(buffer, sizeof(buffer), job)) {
       // Reads and assigns each argument in each structure.
-      if (sscanf(buffer, "%255s %ld %lf %ld %lf",
+      char mode[16] = "";
+      const int fields = sscanf(buffer, "%255s %ld %lf %ld %lf %15s",
         simulation_parameters[line_number].bin_name,
         &simulation_parameters[line_number].delta,
         &simulation_parameters[line_number].alpha,
         &simulation_parameters[line_number].h,
-        &simulation_parameters[line_number].epsilon) != 5) {
-        printf("Error analizing line %s.", buffer);
+        &simulation_parameters[line_number].epsilon, mode);
+      if (fields < 5) {
+        fprintf(stderr, "Missing fields in job line %lu, the line is "
+          "skipped.\n", line_number + 1);
+        simulation_parameters[line_number].malformed = true;
+      } else if (fields == 6 && strcmp(mode, "multigrid") != 0) {
+        fprintf(stderr, "Unknown solver mode %s in job line %lu, the line is "
+          "skipped.\n", mode, line_number + 1);
+        simulation_parameters[line_number].malformed = true;
       }
+      simulation_parameters[line_number].steady = fields == 6 &&
+        strcmp(mode, "multigrid") == 0;
     } else {
-      printf("Error reading job line %lu.\n", line_number);
+      fprintf(stderr, "Could not read job line %lu, the line is "
+        "skipped.\n", line_number + 1);
+      simulation_parameters[line_number].malformed = true;
     }
   }
   fclose(job);
   return simulation_parameters;
 }
 
+/**
+ * @brief Groups the job lines that only differ in epsilon.
+ *
+ * @details Lines with the same plate, delta, alpha and h follow the same
+ * trajectory, so each group is simulated once. The lines of every group are
+ * stored consecutively in 'lines', ordered by decreasing epsilon; lines with
+ * the same epsilon keep the job file order. Steady-state lines are solved
+ * to their own epsilon, so each one is a group of its own. Malformed lines
+ * belong to no group.
+ *
+ * @param params Parameters of every line of the job file.
+ * @param count Number of lines in the job file.
+ * @param lines Array of 'count' elements that receives the lines of every
+ * group. The groups point into it, so it must outlive them.
+ * @param group_count Pointer to store the number of groups.
+ * @return Array of groups, or NULL if memory could not be allocated.
+ */
+SimGroup* group_job_lines(const SimData* params, uint64_t count,
+  uint64_t* lines, uint64_t* group_count) {
+  *group_count = 0;
+  SimGroup* groups = (SimGroup*) calloc(count ? count : 1, sizeof(SimGroup));
+  bool* grouped = (bool*) calloc(count ? count : 1, sizeof(bool));
+  if (!groups || !grouped) {
+    perror("Error allocating memory for simulation groups.");
+    free(groups);
+    free(grouped);
+    return NULL;
+  }
+  uint64_t used = 0;
+  for (uint64_t i = 0; i < count; i++) {
+    if (grouped[i] || params[i].malformed) {
+      continue;
+    }
+    SimGroup* group = &groups[(*group_count)++];
+    uint64_t* group_lines = &lines[used];
+    for (uint64_t j = i; j < count; j++) {
+      if (params[j].malformed ||
+        (j != i && (params[i].steady || params[j].steady))) {
+        continue;
+      }
+      if (grouped[j] || strcmp(params[j].bin_name, params[i].bin_name) != 0 ||
+        params[j].delta != params[i].delta ||
+        params[j].alpha != params[i].alpha || params[j].h != params[i].h) {
+        continue;
+      }
+      // Insert the line after the lines with a greater or equal epsilon.
+      uint64_t position = group->count++;
+      while (position > 0 &&
+        params[group_lines[position - 1]].epsilon < params[j].epsilon) {
+        group_lines[position] = group_lines[position - 1];
+        position--;
+      }
+      group_lines[position] = j;
+      grouped[j] = true;
+    }
+    group->lines = group_lines;
+    group->params = params[i];
+    group->params.epsilon = params[group_lines[group->count - 1]].epsilon;
+    used += group->count;
+  }
+  free(grouped);
+  return groups;
+}
+
 /**
  * @brief Writes the simulation results to a report file.
  *
@@ -92,19 +173,41 @@ void create_report(const char* report_file, uint64_t states, const char* time,
   fclose(tsv_file);
 }
 
+/**
+ * @brief Writes the result of a steady-state job line to a report file.
+ *
+ * @details The states and the simulated time are replaced by the mode, the
+ * number of V-cycles and the residual of the resulting plate.
+ *
+ * @param report_file Name of the report file (.tsv).
+ * @param cycles Number of multigrid V-cycles.
+ * @param residual Largest change one more state would make to a cell.
+ * @param params Structure containing the contents of the work file.
+ */
+void create_steady_report(const char* report_file, uint64_t cycles,
+  double residual, SimData params) {
+  FILE* tsv_file = fopen(report_file, "a");
+  if (!tsv_file) {
+    perror("Error opening report file.");
+    return;
+  }
+  fprintf(tsv_file, "%s\t%ld\t%g\t%ld\t%g\tmultigrid\t%lu\t%g\n",
+    params.bin_name, params.delta, params.alpha, params.h, params.epsilon,
+    cycles, residual);
+  fclose(tsv_file);
+}
+
 /**
  * @brief Writes the final state of the plate to a binary file.
  *
  * @param output_dir Directory where the binary file will be written.
- * @param data Data representing the plate.
- * @param rows Number of rows in the data.
- * @param cols Number of columns in the data.
+ * @param matrix Contiguous matrix representing the plate.
  * @param states Number of states until equilibrium is reached.
  * @param plate_filename Name of the binary file associated with the
  * simulation.
  */
-void write_plate(const char* output_dir, double** data, uint64_t rows,
-  uint64_t cols, uint64_t states, const char* plate_filename) {
+void write_plate(const char* output_dir, const Matrix* matrix,
+  uint64_t states, const char* plate_filename) {
   // Get plate number.
   uint64_t plate_number = 0;
   sscanf(plate_filename, "plate%03lu.bin", &plate_number);
@@ -112,8 +215,19 @@ void write_plate(const char* output_dir, double** data, uint64_t rows,
   char path_to_bin[MAX_PATH_LENGTH];
   snprintf(path_to_bin, sizeof(path_to_bin), "%s/plate%03lu-%lu.bin",
     output_dir, plate_number, states);
+  write_plate_file(path_to_bin, matrix);
+}
 
-  FILE* file = fopen(path_to_bin, "wb");
+/**
+ * @brief Writes a plate to a binary file.
+ *
+ * @param path Path of the binary file.
+ * @param matrix Contiguous matrix representing the plate.
+ */
+void write_plate_file(const char* path, const Matrix* matrix) {
+  const uint64_t rows = matrix->rows;
+  const uint64_t cols = matrix->cols;
+  FILE* file = fopen(path, "wb");
   if (!file) {
     perror("Error opening binary file for writing.");
     return;
@@ -132,7 +246,7 @@ void write_plate(const char* output_dir, double** data, uint64_t rows,
   }
   // Write the temperatures.
   for (uint64_t i = 0; i < rows; i++) {
-    if (fwrite(data[i], sizeof(double), cols, file) != cols) {
+    if (fwrite(matrix_row(matrix, i), sizeof(double), cols, file) != cols) {
       perror("Error writing binary data.");
       fclose(file);
       return;
@@ -6,100 +6,47 @@
  * @brief Configura los parámetros de la simulación y ejecuta la propagación
  * del calor.
  *
- * @details Esta función inicializa las estructuras de datos compartidos, lee
- * una matriz desde un archivo binario, configura los parámetros de la
+ * @details Esta función inicializa las estructuras de datos compartidos con
+ * una lámina que el cargador ya leyó, configura los parámetros de la
  * simulación y ejecuta la propagación del calor utilizando múltiples hilos.
  * También gestiona la memoria y guarda los resultados de la simulación en un
- * archivo y un reporte.
+ * reporte; la lámina resultante la escribe el hilo escritor.
  *
  * @param plate_filename Nombre del archivo binario que contiene los datos
  * iniciales de la lámina.
  * @param params Parámetros de la simulación.
  * @param report_file Nombre del archivo de reporte donde se escribirán los
  * resultados de la simulación.
- * @param input_dir Ruta del directorio donde se encuentra el archivo binario.
+ * @param input_dir Ruta del directorio donde se escribe la lámina resultante.
  * @param thread_count Número de hilos a utilizar para el cálculo en paralelo.
+ * @param plate Temperaturas iniciales; la simulación toma posesión de ellas.
+ * @param writer Escritor que guarda la lámina resultante en segundo plano.
+ * @param topology Topología NUMA para fijar los hilos y repartir la lámina
+ * entre los nodos, o NULL para no hacerlo.
  */
 void configure_simulation(const char* plate_filename, SimData params,
-  const char* report_file, const char* input_dir, uint64_t thread_count) {
-  /** Crear la ruta hacia el archivo binario. */
-  char bin_path[257];
-  snprintf(bin_path, sizeof(bin_path), "%s/%s", input_dir, plate_filename);
-  FILE* plate_file = fopen(bin_path, "rb");
-  if (!plate_file) {
-    fprintf(stderr, "Could not open binary file.\n");
-    return;
-  }
-
+  const char* report_file, const char* input_dir, uint64_t thread_count,
+  Matrix* plate, OutputWriter* writer, const NumaTopology* topology) {
   /** Asignar datos compartidos. */
   SharedData* shared_data = (SharedData*) calloc(1, sizeof(SharedData));
   assert(shared_data);
-
-  /** Leer la cantidad de filas y columnas. */
-  if (fread(&(shared_data->rows), sizeof(uint64_t), 1, plate_file) != 1) {
-    fprintf(stderr, "Error reading the number of rows.\n");
-    fclose(plate_file);
-    free(shared_data);
-    return;
-  }
-  if (fread(&(shared_data->cols), sizeof(uint64_t), 1, plate_file) != 1) {
-    fprintf(stderr, "Error reading the number of columns.\n");
-    fclose(plate_file);
-    free(shared_data);
-    return;
-  }
+  shared_data->matrix = *plate;
+  shared_data->rows = plate->rows;
+  shared_data->cols = plate->cols;
+  plate->buffer = NULL;
+  plate->data = NULL;
 
   /** Ajustar el número de hilos si es mayor que el número de filas. */
   if (thread_count > shared_data->rows) {
     thread_count = shared_data->rows;
   }
 
-  /** Asignación dinámica de memoria para la matriz. */
-  shared_data->matrix = malloc(shared_data->rows * sizeof(double*));
-  if (!shared_data->matrix) {
-    fprintf(stderr, "Could not allocate memory for matrix rows.\n");
-    fclose(plate_file);
-    free(shared_data);
-    return;
-  }
-  for (uint64_t i = 0; i < shared_data->rows; i++) {
-    shared_data->matrix[i] = (double*) malloc(shared_data->cols *
-      sizeof(double));
-    if (!shared_data->matrix[i]) {
-      fprintf(stderr, "Could not allocate memory for row %lu.\n", i);
-      for (uint64_t j = 0; j < i; j++) {
-        free(shared_data->matrix[j]);
-      }
-      free(shared_data->matrix);
-      fclose(plate_file);
-      free(shared_data);
-      return;
-    }
-  }
-
-  /** Rellenar la matriz con las temperaturas. */
-  for (uint64_t i = 0; i < shared_data->rows; i++) {
-    for (uint64_t j = 0; j < shared_data->cols; j++) {
-      if (fread(&(shared_data->matrix[i][j]), sizeof(double), 1, plate_file)
-        != 1) {
-        fprintf(stderr, "Error reading matrix data.\n");
-        for (uint64_t k = 0; k < shared_data->rows; k++) {
-          free(shared_data->matrix[k]);
-        }
-        free(shared_data->matrix);
-        fclose(plate_file);
-        free(shared_data);
-        return;
-      }
-    }
-  }
-  fclose(plate_file);
-
   /** Llenar los datos compartidos con los parámetros de la simulación. */
   shared_data->delta_t = params.delta_t;
   shared_data->alpha = params.alpha;
   shared_data->h = params.h;
   shared_data->epsilon = params.epsilon;
+  shared_data->topology = topology;
 
   /** Iniciar el mutex. */
   pthread_mutex_init(&shared_data->matrix_mutex, NULL);
@@ -116,18 +63,17 @@ void configure_simulation(const char* plate_filename, SimData params,
   char time[49];
   format_time(seconds, time, sizeof(time));
 
-  /** Escribir los nuevos datos de la lámina. */
-  write_plate(input_dir, shared_data->matrix, shared_data->rows,
-    shared_data->cols, states, plate_filename);
+  /**
+   * Entregar la lámina al escritor, que la libera después de escribirla,
+   * para que la siguiente simulación empiece sin esperar al disco.
+   */
+  output_writer_submit(writer, &shared_data->matrix, input_dir, states,
+    plate_filename);
 
   /** Escribir el reporte. */
   create_report(report_file, states, time, params, plate_filename);
 
   /** Liberar la memoria. */
-  for (uint64_t i = 0; i < shared_data->rows; i++) {
-    free(shared_data->matrix[i]);
-  }
-  free(shared_data->matrix);
   free(shared_data);
 }
 
@@ -135,9 +81,13 @@ void configure_simulation(const char* plate_filename, SimData params,
  * @brief Simula la propagación del calor en la matriz utilizando múltiples
  * hilos.
  *
- * @details Esta función distribuye las filas de la matriz entre los hilos,
+ * @details Esta función divide las filas de la matriz en bloques, que un
+ * planificador con robo de trabajo reparte entre los hilos en cada estado,
  * realiza el cálculo en paralelo y verifica si el sistema ha alcanzado el
- * equilibrio térmico.
+ * equilibrio térmico. Los hilos se crean una sola vez; cada estado comienza y
+ * termina con una espera en la barrera compartida, de modo que el hilo
+ * principal solo combina el equilibrio que reporta cada hilo e intercambia
+ * las dos matrices, sin recorrer la lámina ni copiar datos entre estados.
  *
  * @param states Puntero a la variable que almacena el número de estados hasta
  * el equilibrio.
@@ -149,81 +99,140 @@ void simulate(uint64_t* states, uint64_t thread_count,
   pthread_t* threads = (pthread_t*) malloc(thread_count * sizeof(pthread_t));
   assert(threads);
 
-  ThreadData* thread_data = (ThreadData*) malloc(thread_count *
-    sizeof(ThreadData));
+  /** Los datos de cada hilo ocupan líneas de caché distintas. */
+  ThreadData* thread_data = (ThreadData*) aligned_alloc(CACHE_LINE_SIZE,
+    thread_count * sizeof(ThreadData));
   assert(thread_data);
 
-  /** Asignar memoria para una copia de la matriz. */
-  double** matrix_copy = (double**) malloc(shared_data->rows *
-    sizeof(double*));
-  for (uint64_t i = 0; i < shared_data->rows; i++) {
-    matrix_copy[i] = (double*) malloc(shared_data->cols * sizeof(double));
+  /**
+   * Asignar la matriz del siguiente estado. Se copia una sola vez para que
+   * ambas matrices compartan los bordes, que no cambian. Con topología NUMA
+   * ambas matrices se reservan sin tocar y cada hilo copia sus filas de la
+   * lámina cargada, que se libera antes del primer estado.
+   */
+  const bool numa = shared_data->topology != NULL;
+  int allocated = EXIT_FAILURE;
+  if (numa) {
+    shared_data->initial = shared_data->matrix;
+    allocated = matrix_reserve(&shared_data->matrix, shared_data->rows,
+      shared_data->cols);
+    if (allocated == EXIT_SUCCESS) {
+      allocated = matrix_reserve(&shared_data->next_matrix, shared_data->rows,
+        shared_data->cols);
+      if (allocated != EXIT_SUCCESS) {
+        matrix_destroy(&shared_data->matrix);
+      }
+    }
+    if (allocated != EXIT_SUCCESS) {
+      shared_data->matrix = shared_data->initial;
+    }
+  } else {
+    allocated = matrix_create(&shared_data->next_matrix, shared_data->rows,
+      shared_data->cols);
+    if (allocated == EXIT_SUCCESS) {
+      memcpy(shared_data->next_matrix.buffer, shared_data->matrix.buffer,
+        shared_data->rows * shared_data->matrix.stride * sizeof(double));
+    }
+  }
+  if (allocated != EXIT_SUCCESS) {
+    fprintf(stderr, "Could not allocate memory for matrix copy.\n");
+    free(threads);
+    free(thread_data);
+    return;
+  }
+
+  /** Dividir las filas internas en bloques, con una cola por hilo. */
+  TileScheduler* scheduler = &shared_data->scheduler;
+  if (tile_scheduler_init(scheduler, shared_data->rows, thread_count)
+    != EXIT_SUCCESS) {
+    fprintf(stderr, "Could not allocate memory for tile deques.\n");
+    if (numa) {
+      matrix_destroy(&shared_data->matrix);
+      shared_data->matrix = shared_data->initial;
+    }
+    matrix_destroy(&shared_data->next_matrix);
+    free(threads);
+    free(thread_data);
+    return;
   }
 
   uint64_t state = 0;
   bool equilibrium = false;
 
+  /** La barrera incluye a los hilos de trabajo y al hilo principal. */
+  pthread_barrier_init(&shared_data->step_barrier, NULL, thread_count + 1);
+  shared_data->finished = false;
+
+  /**
+   * Crear los hilos una sola vez. Las filas de cada hilo son las de sus
+   * bloques propios.
+   */
+  for (uint64_t i = 0; i < thread_count; i++) {
+    thread_data[i].start_row = tile_scheduler_row(scheduler,
+      scheduler->deques[i].first_tile);
+    thread_data[i].end_row = tile_scheduler_row(scheduler,
+      scheduler->deques[i].last_tile);
+    thread_data[i].index = i;
+    thread_data[i].thread_count = thread_count;
+    thread_data[i].shared_data = shared_data;
+    pthread_create(&threads[i], NULL, thread_sim, &thread_data[i]);
+  }
+
+  /** Esperar a que los hilos copien sus filas y liberar la lámina cargada. */
+  if (numa) {
+    pthread_barrier_wait(&shared_data->step_barrier);
+    matrix_destroy(&shared_data->initial);
+  }
+
   while (!equilibrium) {
     equilibrium = true;
     state++;
 
-    /** Copiar la matriz antes de que los hilos la actualicen. */
-    for (uint64_t i = 0; i < shared_data->rows; i++) {
-      for (uint64_t j = 0; j < shared_data->cols; j++) {
-        matrix_copy[i][j] = shared_data->matrix[i][j];
-      }
-    }
-
-    /** Distribuir el trabajo entre los hilos. */
-    for (uint64_t i = 0; i < thread_count; i++) {
-      uint64_t rows_per_thread = (shared_data->rows - 2) / thread_count;
-      thread_data[i].start_row = 1 + i * rows_per_thread;
-      thread_data[i].end_row = (i == thread_count - 1) ?
-        shared_data->rows - 1 : thread_data[i].start_row + rows_per_thread;
-      thread_data[i].shared_data = shared_data;
-
-      /** Crear los hilos. */
-      pthread_create(&threads[i], NULL, thread_sim, &thread_data[i]);
-    }
+    /** Llenar las colas, liberar a los hilos y esperar a que terminen. */
+    tile_scheduler_reset(scheduler);
+    pthread_barrier_wait(&shared_data->step_barrier);
+    pthread_barrier_wait(&shared_data->step_barrier);
 
-    /** Esperar que todos los hilos terminen. */
+    /** Verificar el equilibrio térmico con el resultado de cada hilo. */
     for (uint64_t i = 0; i < thread_count; i++) {
-      pthread_join(threads[i], NULL);
-    }
-
-    /** Verificar el equilibrio térmico. */
-    for (uint64_t i = 1; i < shared_data->rows - 1; i++) {
-      for (uint64_t j = 1; j < shared_data->cols - 1; j++) {
-        double cell = shared_data->matrix[i][j];
-        if (fabs(matrix_copy[i][j] - cell) >= shared_data->epsilon) {
-          equilibrium = false;
-          break;
-        }
-      }
-      if (!equilibrium) {
+      if (!thread_data[i].equilibrium) {
+        equilibrium = false;
         break;
       }
     }
+
+    /** Intercambiar las matrices: el nuevo estado pasa a ser el actual. */
+    Matrix temp = shared_data->matrix;
+    shared_data->matrix = shared_data->next_matrix;
+    shared_data->next_matrix = temp;
   }
 
   *states = state;
 
-  /** Liberar memoria. */
-  for (uint64_t i = 0; i < shared_data->rows; i++) {
-    free(matrix_copy[i]);
+  /** Indicar a los hilos que terminen y esperar a que salgan. */
+  shared_data->finished = true;
+  pthread_barrier_wait(&shared_data->step_barrier);
+  for (uint64_t i = 0; i < thread_count; i++) {
+    pthread_join(threads[i], NULL);
   }
-  free(matrix_copy);
+  pthread_barrier_destroy(&shared_data->step_barrier);
+
+  /** Liberar memoria. */
+  tile_scheduler_destroy(scheduler);
+  matrix_destroy(&shared_data->next_matrix);
   free(threads);
   free(thread_data);
 }
 
 /**
- * @brief Función que ejecuta cada hilo para simular la propagación del calor
- * en un rango de filas de la matriz.
+ * @brief Rutina de cada hilo del equipo de simulación.
  *
- * @details Cada hilo es responsable de actualizar una porción de la matriz
- * basada en la ecuación de propagación del calor. Los valores actualizados se
- * escriben de vuelta en la matriz compartida.
+ * @details El hilo vive mientras dure la simulación de la lámina. En cada
+ * estado espera en la barrera a que el hilo principal lo libere, actualiza sus
+ * filas y vuelve a esperar para indicar que terminó. Con topología NUMA,
+ * antes del primer estado se fija a su CPU y es el primero en escribir sus
+ * filas de ambas matrices, con los bordes vecinos en el primer y el último
+ * hilo.
  *
  * @param data Puntero a los datos privados del hilo, que contiene su rango de
  * filas y los datos compartidos.
@@ -234,40 +243,76 @@ void* thread_sim(void* data) {
   ThreadData* thread_data = (ThreadData*) data;
   SharedData* shared_data = thread_data->shared_data;
 
-  uint64_t delta_t = shared_data->delta_t;
-  uint64_t h = shared_data->h;
-  double alpha = shared_data->alpha;
-  double** matrix = shared_data->matrix;
-
-  /** Crear una copia de la matriz en la memoria local del hilo. */
-  double** thread_matrix = malloc(shared_data->rows * sizeof(double*));
-  for (uint64_t i = 0; i < shared_data->rows; i++) {
-    thread_matrix[i] = malloc(shared_data->cols * sizeof(double));
+  if (shared_data->topology) {
+    numa_pin_thread(shared_data->topology, thread_data->index,
+      thread_data->thread_count);
+    const uint64_t first = thread_data->index == 0 ? 0 :
+      thread_data->start_row;
+    const uint64_t last = thread_data->index == thread_data->thread_count - 1 ?
+      shared_data->rows : thread_data->end_row;
+    matrix_copy_rows(&shared_data->matrix, &shared_data->initial, first,
+      last);
+    matrix_copy_rows(&shared_data->next_matrix, &shared_data->initial, first,
+      last);
+    pthread_barrier_wait(&shared_data->step_barrier);
   }
 
-  /** Realizar la simulación con las filas correspondientes. */
-  for (uint64_t i = thread_data->start_row; i < thread_data->end_row; i++) {
-    for (uint64_t j = 1; j < shared_data->cols - 1; j++) {
-      double cell = matrix[i][j];
-      double cells_around = matrix[i-1][j] + matrix[i][j+1] + matrix[i+1][j] +
-        matrix[i][j-1];
-      thread_matrix[i][j] = cell + (delta_t * alpha / (h * h)) *
-        (cells_around - 4 * cell);
+  while (true) {
+    /** Esperar el inicio de un nuevo estado. */
+    pthread_barrier_wait(&shared_data->step_barrier);
+    if (shared_data->finished) {
+      break;
     }
+    simulate_rows(thread_data);
+    /** Avisar que las filas de este hilo están listas. */
+    pthread_barrier_wait(&shared_data->step_barrier);
   }
+  return NULL;
+}
 
-  /** Copiar los resultados en la matriz compartida. */
-  for (uint64_t i = thread_data->start_row; i < thread_data->end_row; i++) {
-    for (uint64_t j = 1; j < shared_data->cols - 1; j++) {
-      shared_data->matrix[i][j] = thread_matrix[i][j];
-    }
-  }
+/**
+ * @brief Simula un estado de la propagación del calor en los bloques de
+ * filas que obtiene un hilo.
+ *
+ * @details El hilo toma bloques de filas del planificador hasta que no quedan
+ * en el estado: primero los propios y luego los que roba de los demás hilos.
+ * Actualiza cada bloque con la ecuación de propagación del calor. Lee el
+ * estado actual de 'matrix' y escribe los valores nuevos directamente en
+ * 'next_matrix'. En el mismo recorrido revisa si sus filas alcanzaron el
+ * equilibrio.
+ *
+ * @param thread_data Datos privados del hilo, que contienen su rango de filas
+ * y los datos compartidos.
+ */
+void simulate_rows(ThreadData* thread_data) {
+  SharedData* shared_data = thread_data->shared_data;
 
-  /** Liberar la memoria local. */
-  for (uint64_t i = 0; i < shared_data->rows; i++) {
-    free(thread_matrix[i]);
+  uint64_t delta_t = shared_data->delta_t;
+  uint64_t h = shared_data->h;
+  double alpha = shared_data->alpha;
+  const Matrix* matrix = &shared_data->matrix;
+  const Matrix* next_matrix = &shared_data->next_matrix;
+  const double epsilon = shared_data->epsilon;
+  const double factor = delta_t * alpha / (h * h);
+  bool equilibrium = true;
+  uint64_t first_row = 0, last_row = 0;
+
+  /** Realizar la simulación con las filas de cada bloque obtenido. */
+  while (tile_scheduler_next(&shared_data->scheduler, thread_data->index,
+    &first_row, &last_row)) {
+    for (uint64_t i = first_row; i < last_row; i++) {
+      const double* up = matrix_row(matrix, i - 1);
+      const double* row = matrix_row(matrix, i);
+      const double* down = matrix_row(matrix, i + 1);
+      double* next = matrix_row(next_matrix, i);
+      /** Calcular la fila con el kernel vectorial disponible. */
+      if (stencil_row(up, row, down, next, shared_data->cols, factor) >=
+        epsilon) {
+        equilibrium = false;
+      }
+    }
   }
-  free(thread_matrix);
 
-  return NULL;
+  /** La barrera del estado hace visible el resultado al hilo principal. */
+  thread_data->equilibrium = equilibrium;
 }
@@ -6,13 +6,48 @@
 /** Especificar el tamaño máximo permitido para las rutas de archivos. */
 #define MAX_PATH_LENGTH 1024
 
-/** Medir tiempo de ejecución. */
-#define _POSIX_C_SOURCE 199309L
+/** Medir tiempo de ejecución y usar barreras de pthreads. */
+#define _POSIX_C_SOURCE 200809L
+
+/**
+ * Láminas terminadas que pueden esperar al escritor a la vez, incluida la que
+ * se está escribiendo. Limita la memoria que ocupan las láminas de salida.
+ */
+#ifndef OUTPUT_QUEUE_CAPACITY
+#define OUTPUT_QUEUE_CAPACITY 2
+#endif
+
+/** Tamaño de cada escritura de una lámina de salida. */
+#define OUTPUT_CHUNK_BYTES (4 * 1024 * 1024)
+
+/** Alineación del buffer y del tamaño de las escrituras para O_DIRECT. */
+#define OUTPUT_ALIGNMENT 4096
+
+/**
+ * Láminas que el cargador puede leer por adelantado y memoria que pueden
+ * ocupar mientras esperan la simulación. Se pueden cambiar al compilar, por
+ * ejemplo DEFS="-DPREFETCH_PLATES=4 -DPREFETCH_BUDGET_BYTES=268435456".
+ */
+#ifndef PREFETCH_PLATES
+#define PREFETCH_PLATES 2
+#endif
+#ifndef PREFETCH_BUDGET_BYTES
+#define PREFETCH_BUDGET_BYTES (1024ULL * 1024 * 1024)
+#endif
+
+/**
+ * Bloques de filas de cada hilo en el planificador con robo de trabajo. Con 1
+ * cada hilo tiene un solo bloque, como en el reparto estático.
+ */
+#ifndef STEAL_TILES_PER_THREAD
+#define STEAL_TILES_PER_THREAD 4
+#endif
 
 #include <assert.h>
 #include <inttypes.h>
 #include <math.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -21,6 +56,9 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "matrix.h"
+#include "stencil.h"
+
 /**
  * @brief Estructura que almacena los parámetros de la simulación.
  *
@@ -33,45 +71,189 @@ typedef struct simulation_parameters {
   uint64_t delta_t, h;
 } SimData;
 
+/**
+ * @brief Topología NUMA del equipo, leída de sysfs.
+ *
+ * @details 'cpus' guarda los CPUs de todos los nodos, nodo por nodo; los del
+ * nodo i van de cpus[first[i]] a cpus[first[i + 1] - 1].
+ */
+typedef struct numa_topology {
+  uint64_t node_count;
+  uint64_t* first;  /** node_count + 1 posiciones en 'cpus'. */
+  int* cpus;
+  uint64_t cpu_count, cpu_capacity;
+} NumaTopology;
+
+/**
+ * @brief Cola doble de bloques de filas de un hilo.
+ *
+ * @details 'range' guarda el primer bloque pendiente en los 32 bits altos y
+ * el siguiente al último en los bajos. El dueño toma bloques del frente y los
+ * demás hilos roban del final; ambos cambian 'range' con una sola operación
+ * de comparar e intercambiar, por lo que cada bloque se calcula una vez. Cada
+ * cola ocupa su propia línea de caché.
+ */
+typedef struct tile_deque {
+  _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t range;
+  uint64_t first_tile, last_tile;  /** Bloques propios del hilo. */
+} TileDeque;
+
+/**
+ * @brief Planificador de los bloques de filas de un estado.
+ *
+ * @details Las filas internas se dividen en 'tile_count' bloques contiguos.
+ * Cada hilo recibe siempre los mismos bloques vecinos, de modo que en
+ * régimen estable cada uno recorre las mismas filas y conserva su caché;
+ * solo los hilos que terminan antes roban bloques de los demás.
+ */
+typedef struct tile_scheduler {
+  TileDeque* deques;  /** Una cola por hilo. */
+  uint64_t deque_count, tile_count, inner_rows;
+} TileScheduler;
+
 /**
  * @brief Estructura que guarda los datos compartidos entre los hilos para la
  * simulación.
  *
  * @details Contiene la información de la lámina y sus propiedades, así como la
- * matriz de datos que representa las temperaturas de cada celda.
+ * matriz de datos que representa las temperaturas de cada celda. Los hilos se
+ * crean una vez por lámina y avanzan los estados sincronizados por
+ * 'step_barrier'; 'finished' les indica que la simulación terminó. 'matrix'
+ * guarda el estado actual y 'next_matrix' recibe el siguiente; ambas se
+ * intercambian al final de cada estado. Con 'topology', cada hilo se fija a
+ * un CPU y copia sus filas de 'initial' a ambas matrices antes del primer
+ * estado, de modo que quedan en la memoria de su nodo NUMA. 'scheduler'
+ * reparte los bloques de filas de cada estado.
  */
 typedef struct shared_thread_data {
-  double** matrix;
+  Matrix matrix, next_matrix, initial;
+  const NumaTopology* topology;
+  TileScheduler scheduler;
   uint64_t cols, rows, delta_t, h, next_row;
   double alpha, epsilon;
   pthread_mutex_t matrix_mutex, work_mutex;
+  pthread_barrier_t step_barrier;
+  bool finished;
 } SharedData;
 
 /**
  * @brief Estructura que almacena los datos privados para cada hilo.
  *
- * @details Esta estructura define el rango de filas que un hilo debe procesar
- * durante la simulación.
+ * @details Esta estructura define el rango de filas de los bloques propios
+ * del hilo, que son las que copia primero con topología NUMA; en cada estado
+ * el hilo calcula los bloques que toma del planificador. Cada hilo escribe
+ * en 'equilibrium' si los bloques que calculó alcanzaron el equilibrio en el
+ * último estado; el campo ocupa su propia línea de caché para que los hilos
+ * no compartan líneas al escribirlo.
  */
 typedef struct private_thread_data {
+  _Alignas(CACHE_LINE_SIZE) bool equilibrium;
   uint64_t start_row, end_row;
+  uint64_t index, thread_count;  /** Lugar del hilo en el equipo. */
   SharedData* shared_data;
 } ThreadData;
 
+/**
+ * @brief Lámina terminada que espera en la cola del escritor.
+ */
+typedef struct plate_output {
+  Matrix matrix;  /** Estado final; el escritor la libera al escribirla. */
+  char path[MAX_PATH_LENGTH];  /** Ruta del archivo de salida. */
+} PlateOutput;
+
+/**
+ * @brief Escritor de láminas en segundo plano.
+ *
+ * @details Las láminas terminadas se entregan por medio de una cola circular
+ * acotada, protegida por 'mutex'. Mientras el hilo escritor guarda una lámina,
+ * los hilos de cálculo pueden empezar la siguiente. 'files' guarda los
+ * archivos escritos para sincronizarlos con el disco al final del trabajo.
+ */
+typedef struct output_writer {
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t not_empty, not_full;
+  PlateOutput queue[OUTPUT_QUEUE_CAPACITY];
+  uint64_t head, count;
+  bool finished;
+  char* staging;  /** Buffer alineado de OUTPUT_CHUNK_BYTES. */
+  char** files;
+  uint64_t file_count, file_capacity;
+} OutputWriter;
+
+/**
+ * @brief Lámina de una línea del trabajo leída por adelantado.
+ */
+typedef struct loaded_plate {
+  Matrix matrix;  /** Temperaturas iniciales, listas para simular. */
+  uint64_t bytes;  /** Memoria que cuenta en el presupuesto. */
+  int status;  /** EXIT_SUCCESS si la lámina se pudo cargar. */
+  bool ready;  /** El cargador terminó con esta lámina. */
+} LoadedPlate;
+
+/**
+ * @brief Cargador de láminas en segundo plano.
+ *
+ * @details Mientras se simula una lámina, el hilo cargador lee las siguientes
+ * del archivo de trabajo, hasta PREFETCH_PLATES láminas o
+ * PREFETCH_BUDGET_BYTES de memoria por delante de la simulación. 'taken' es
+ * el número de láminas que la simulación ya tomó y 'waiting' indica que la
+ * simulación está esperando la siguiente. Todos los campos que comparten los
+ * hilos se protegen con 'mutex'.
+ */
+typedef struct plate_loader {
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t changed;
+  const SimData* params;
+  const char* input_dir;
+  uint64_t count, thread_count;
+  LoadedPlate* plates;
+  uint64_t taken, used_bytes;
+  bool waiting, finished;
+} PlateLoader;
+
 /** Declaración de funciones relacionadas con la simulación de calor. */
 void configure_simulation(const char* plate_filename, SimData params,
-  const char* filepath, const char* input_dir, uint64_t thread_count);
+  const char* filepath, const char* input_dir, uint64_t thread_count,
+  Matrix* plate, OutputWriter* writer, const NumaTopology* topology);
 void simulate(uint64_t* states, uint64_t thread_count,
   SharedData* shared_data);
 void* thread_sim(void* data);
+void simulate_rows(ThreadData* thread_data);
+
+/** Declaración del planificador de bloques en scheduler.c. */
+int tile_scheduler_init(TileScheduler* scheduler, uint64_t rows,
+  uint64_t thread_count);
+void tile_scheduler_destroy(TileScheduler* scheduler);
+void tile_scheduler_reset(TileScheduler* scheduler);
+uint64_t tile_scheduler_row(const TileScheduler* scheduler, uint64_t tile);
+bool tile_scheduler_next(TileScheduler* scheduler, uint64_t index,
+  uint64_t* first_row, uint64_t* last_row);
 
 /** Declaración de funciones auxiliares en utils.c. */
 uint64_t count_job_lines(FILE* bin_name);
 SimData* read_job_file(const char* job_file, uint64_t* struct_count);
 void create_report(const char* report_file, uint64_t states, const char* time,
   SimData params, const char* plate_filename);
-void write_plate(const char* output_dir, double** data, uint64_t rows,
-  uint64_t cols, uint64_t states, const char* plate_filename);
 char* format_time(const time_t seconds, char* text, const size_t capacity);
 
+/** Declaración del escritor de láminas en writer.c. */
+int output_writer_start(OutputWriter* writer);
+void output_writer_submit(OutputWriter* writer, Matrix* matrix,
+  const char* output_dir, uint64_t states, const char* plate_filename);
+void output_writer_finish(OutputWriter* writer);
+
+/** Declaración del cargador de láminas en loader.c. */
+int plate_loader_start(PlateLoader* loader, const SimData* params,
+  uint64_t count, const char* input_dir, uint64_t thread_count);
+int plate_loader_take(PlateLoader* loader, uint64_t line, Matrix* matrix);
+void plate_loader_stop(PlateLoader* loader);
+
+/** Declaración de las funciones NUMA en numa.c. */
+int numa_topology_read(NumaTopology* topology);
+void numa_topology_destroy(NumaTopology* topology);
+int numa_pin_thread(const NumaTopology* topology, uint64_t index,
+  uint64_t thread_count);
+
 #endif  // HEAT_SIMULATION_H
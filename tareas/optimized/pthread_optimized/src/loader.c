@@ -0,0 +1,172 @@
+// Copyright 2024 Josué Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+#include "heat_simulation.h"
+
+/**
+ * @brief Indica si el cargador puede leer la lámina 'line' sin pasarse de
+ * los límites de lectura anticipada.
+ *
+ * @details La lámina que la simulación necesita a continuación siempre se
+ * puede leer, aunque no quepa en el presupuesto; así una lámina más grande
+ * que PREFETCH_BUDGET_BYTES no detiene el trabajo.
+ *
+ * @param loader Cargador de láminas, con su mutex tomado.
+ * @param line Línea del archivo de trabajo que se quiere leer.
+ * @param bytes Memoria que ocupará la lámina.
+ * @return true si la lámina se puede leer ahora.
+ */
+static bool can_prefetch(const PlateLoader* loader, uint64_t line,
+  uint64_t bytes) {
+  if (line == loader->taken) {
+    return true;
+  }
+  return line - loader->taken < PREFETCH_PLATES &&
+    loader->used_bytes + bytes <= PREFETCH_BUDGET_BYTES;
+}
+
+/**
+ * @brief Rutina del hilo cargador.
+ *
+ * @details Recorre las líneas del trabajo en orden. Para cada una proyecta el
+ * archivo, espera a que la lámina quepa en los límites de lectura anticipada
+ * y la copia a una matriz lista para simular. Si la simulación ya está
+ * esperando la lámina, la copia se reparte entre los hilos de la simulación,
+ * que de otro modo estarían ociosos; si no, la hace este hilo solo.
+ *
+ * @param data Puntero al PlateLoader.
+ * @return NULL
+ */
+static void* run_loader(void* data) {
+  PlateLoader* loader = (PlateLoader*) data;
+  for (uint64_t line = 0; line < loader->count; line++) {
+    LoadedPlate* plate = &loader->plates[line];
+    /** Crear la ruta hacia el archivo binario. */
+    char bin_path[MAX_PATH_LENGTH];
+    snprintf(bin_path, sizeof(bin_path), "%s/%s", loader->input_dir,
+      loader->params[line].bin_name);
+    /** Proyectar el archivo; su encabezado se valida con el tamaño. */
+    PlateMap plate_map;
+    const int opened = plate_map_open(&plate_map, bin_path);
+    if (opened == EXIT_SUCCESS) {
+      plate->bytes = plate_map.rows * plate_map.cols * sizeof(double);
+    }
+
+    pthread_mutex_lock(&loader->mutex);
+    while (!loader->finished && !can_prefetch(loader, line, plate->bytes)) {
+      pthread_cond_wait(&loader->changed, &loader->mutex);
+    }
+    const bool finished = loader->finished;
+    const uint64_t thread_count = loader->waiting ? loader->thread_count : 1;
+    loader->used_bytes += plate->bytes;
+    pthread_mutex_unlock(&loader->mutex);
+    if (finished) {
+      if (opened == EXIT_SUCCESS) {
+        plate_map_close(&plate_map);
+      }
+      break;
+    }
+
+    int status = EXIT_FAILURE;
+    if (opened != EXIT_SUCCESS) {
+      fprintf(stderr, "Could not open binary file.\n");
+    } else {
+      status = matrix_load(&plate->matrix, &plate_map, thread_count);
+      if (status != EXIT_SUCCESS) {
+        fprintf(stderr, "Could not allocate memory for matrix.\n");
+      }
+      plate_map_close(&plate_map);
+    }
+
+    pthread_mutex_lock(&loader->mutex);
+    plate->status = status;
+    plate->ready = true;
+    pthread_cond_broadcast(&loader->changed);
+    pthread_mutex_unlock(&loader->mutex);
+  }
+  return NULL;
+}
+
+/**
+ * @brief Inicia el hilo que lee por adelantado las láminas del trabajo.
+ *
+ * @param loader Cargador a inicializar.
+ * @param params Parámetros de cada línea del archivo de trabajo.
+ * @param count Número de líneas del archivo de trabajo.
+ * @param input_dir Directorio donde se encuentran los archivos binarios.
+ * @param thread_count Hilos de la simulación, que ayudan a copiar una lámina
+ * cuando la simulación la está esperando.
+ * @return EXIT_SUCCESS si el hilo se creó, o EXIT_FAILURE si ocurre un error.
+ */
+int plate_loader_start(PlateLoader* loader, const SimData* params,
+  uint64_t count, const char* input_dir, uint64_t thread_count) {
+  memset(loader, 0, sizeof(PlateLoader));
+  loader->params = params;
+  loader->count = count;
+  loader->input_dir = input_dir;
+  loader->thread_count = thread_count;
+  loader->plates = (LoadedPlate*) calloc(count ? count : 1,
+    sizeof(LoadedPlate));
+  if (!loader->plates) {
+    fprintf(stderr, "Could not allocate memory for plate loader.\n");
+    return EXIT_FAILURE;
+  }
+  pthread_mutex_init(&loader->mutex, NULL);
+  pthread_cond_init(&loader->changed, NULL);
+  if (pthread_create(&loader->thread, NULL, run_loader, loader) != 0) {
+    fprintf(stderr, "Could not create plate loader thread.\n");
+    pthread_mutex_destroy(&loader->mutex);
+    pthread_cond_destroy(&loader->changed);
+    free(loader->plates);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Toma la lámina ya cargada de una línea del trabajo.
+ *
+ * @details Espera a que el cargador termine de leerla, si todavía no lo ha
+ * hecho. La memoria de la lámina deja de contar en el presupuesto de lectura
+ * anticipada, de modo que el cargador puede empezar con las siguientes.
+ *
+ * @param loader Cargador de láminas.
+ * @param line Línea del archivo de trabajo; se toman en orden.
+ * @param matrix Recibe la lámina; el llamador debe liberarla.
+ * @return EXIT_SUCCESS si la lámina se cargó, o EXIT_FAILURE si no.
+ */
+int plate_loader_take(PlateLoader* loader, uint64_t line, Matrix* matrix) {
+  LoadedPlate* plate = &loader->plates[line];
+  pthread_mutex_lock(&loader->mutex);
+  loader->waiting = true;
+  while (!plate->ready) {
+    pthread_cond_wait(&loader->changed, &loader->mutex);
+  }
+  loader->waiting = false;
+  *matrix = plate->matrix;
+  memset(&plate->matrix, 0, sizeof(Matrix));
+  loader->used_bytes -= plate->bytes;
+  loader->taken = line + 1;
+  pthread_cond_broadcast(&loader->changed);
+  pthread_mutex_unlock(&loader->mutex);
+  return plate->status;
+}
+
+/**
+ * @brief Detiene el hilo cargador y libera las láminas que no se tomaron.
+ *
+ * @param loader Cargador de láminas.
+ */
+void plate_loader_stop(PlateLoader* loader) {
+  pthread_mutex_lock(&loader->mutex);
+  loader->finished = true;
+  pthread_cond_broadcast(&loader->changed);
+  pthread_mutex_unlock(&loader->mutex);
+  pthread_join(loader->thread, NULL);
+
+  for (uint64_t i = 0; i < loader->count; i++) {
+    matrix_destroy(&loader->plates[i].matrix);
+  }
+  free(loader->plates);
+  pthread_mutex_destroy(&loader->mutex);
+  pthread_cond_destroy(&loader->changed);
+}
@@ -24,7 +24,12 @@
  * puede utilizar una cantidad de hilos especificada por el usuario o detectar
  * el número de procesadores disponibles para determinar la cantidad de hilos a
  * crear. Se utiliza la cantidad de hilos ingresada para hacer operaciones
- * sobre la matriz, repartiendo el trabajo de forma equitativa entre ellos.
+ * sobre la matriz, repartiendo el trabajo de forma equitativa entre ellos;
+ * los hilos que terminan sus bloques de filas antes roban bloques de los
+ * demás.
+ * Con la opción --numa, en cualquier posición, los hilos se fijan a los CPUs
+ * de los nodos NUMA que describe sysfs y cada uno escribe primero sus filas,
+ * para que queden en la memoria de su nodo.
  *
  * @param argc Cantidad de argumentos pasados por línea de comandos.
  * @param argv Argumentos de línea de comandos.
@@ -34,6 +39,22 @@ int main(int argc, char *argv[]) {
   struct timespec start_time, finish_time;
   clock_gettime(/*clk_id*/CLOCK_MONOTONIC, &start_time);
 
+  /** Elegir el kernel de la simulación según el procesador. */
+  stencil_init();
+
+  /** Retirar la opción --numa de los argumentos, en cualquier posición. */
+  bool numa = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--numa") == 0) {
+      numa = true;
+      for (int j = i; j < argc - 1; j++) {
+        argv[j] = argv[j + 1];
+      }
+      argc--;
+      i--;
+    }
+  }
+
   /**
    * Verificar que los argumentos proporcionados en la línea de comandos sean
    * correctos.
@@ -47,7 +68,7 @@ int main(int argc, char *argv[]) {
      * Los "job" pueden ser reemplazados por el número de job que se desee.
      */
     fprintf(stderr, "Usage: <job file> <input dir> <output dir> "
-      "<thread_count>\n");
+      "<thread_count> [--numa]\n");
     return 11;
   }
   const char* job_filename = argv[1];
@@ -89,14 +110,54 @@ int main(int argc, char *argv[]) {
     return 1;
   }
 
+  /** Iniciar el hilo que escribe las láminas resultantes. */
+  OutputWriter writer;
+  if (output_writer_start(&writer) != EXIT_SUCCESS) {
+    free(simulation_parameters);
+    return 1;
+  }
+
+  /**
+   * Iniciar el hilo que lee las láminas por adelantado. Con el escritor, cada
+   * lámina se carga, se simula y se escribe mientras las vecinas avanzan en
+   * las otras etapas.
+   */
+  PlateLoader loader;
+  if (plate_loader_start(&loader, simulation_parameters, struct_count,
+    input_dir, thread_count) != EXIT_SUCCESS) {
+    output_writer_finish(&writer);
+    free(simulation_parameters);
+    return 1;
+  }
+
+  /** Leer la topología NUMA; sin ella los hilos no se fijan. */
+  NumaTopology numa_topology;
+  const NumaTopology* topology = NULL;
+  if (numa) {
+    if (numa_topology_read(&numa_topology) == EXIT_SUCCESS) {
+      topology = &numa_topology;
+    } else {
+      fprintf(stderr, "Could not read NUMA topology, threads are not "
+        "pinned.\n");
+    }
+  }
+
   const char* plate_filename;
   for (uint64_t i = 0; i < struct_count; i++) {
     plate_filename = simulation_parameters[i].bin_name;
-    /** Ejecutar la simulación. */
+    /** Tomar la lámina ya cargada y ejecutar la simulación. */
+    Matrix plate;
+    if (plate_loader_take(&loader, i, &plate) != EXIT_SUCCESS) {
+      continue;
+    }
     configure_simulation(plate_filename, simulation_parameters[i], report_path,
-      input_dir, thread_count);
+      input_dir, thread_count, &plate, &writer, topology);
   }
 
+  /** Detener el cargador y esperar a que se escriban todas las láminas. */
+  plate_loader_stop(&loader);
+  output_writer_finish(&writer);
+
   /** Tomar el tiempo de finalización. */
   clock_gettime(/*clk_id*/CLOCK_MONOTONIC, &finish_time);
 
@@ -111,5 +172,8 @@ int main(int argc, char *argv[]) {
 
   /** Liberar memoria. */
   free(simulation_parameters);
+  if (topology) {
+    numa_topology_destroy(&numa_topology);
+  }
   return 0;
 }
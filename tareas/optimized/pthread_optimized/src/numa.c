@@ -0,0 +1,136 @@
+// Copyright 2024 Josué Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+/** Usar pthread_setaffinity_np y cpu_set_t. */
+#define _GNU_SOURCE
+
+#include <sched.h>
+
+#include "heat_simulation.h"
+
+/** Directorio de sysfs con los nodos NUMA. */
+#define NUMA_SYSFS_NODES "/sys/devices/system/node"
+
+/**
+ * @brief Agrega los CPUs de una lista de sysfs, como "0-3,8-11", al arreglo
+ * de CPUs de la topología.
+ *
+ * @param topology Topología que recibe los CPUs.
+ * @param list Lista de CPUs de un nodo.
+ * @return EXIT_SUCCESS si se agregaron, EXIT_FAILURE si falta memoria.
+ */
+static int add_cpu_list(NumaTopology* topology, const char* list) {
+  const char* cursor = list;
+  while (*cursor >= '0' && *cursor <= '9') {
+    char* end = NULL;
+    const long first = strtol(cursor, &end, 10);
+    long last = first;
+    if (*end == '-') {
+      last = strtol(end + 1, &end, 10);
+    }
+    for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+      if (topology->cpu_count == topology->cpu_capacity) {
+        const uint64_t capacity = topology->cpu_capacity ?
+          2 * topology->cpu_capacity : 64;
+        int* cpus = (int*) realloc(topology->cpus, capacity * sizeof(int));
+        if (!cpus) {
+          return EXIT_FAILURE;
+        }
+        topology->cpus = cpus;
+        topology->cpu_capacity = capacity;
+      }
+      topology->cpus[topology->cpu_count++] = (int) cpu;
+    }
+    cursor = *end == ',' ? end + 1 : end;
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Lee de sysfs los nodos NUMA del equipo y los CPUs de cada uno.
+ *
+ * @details Se recorren los directorios nodeN en orden hasta el primero que no
+ * existe. Los nodos sin CPUs, que solo aportan memoria, se omiten.
+ *
+ * @param topology Recibe la topología; se libera con numa_topology_destroy.
+ * @return EXIT_SUCCESS si se encontró al menos un nodo con CPUs, EXIT_FAILURE
+ * si no.
+ */
+int numa_topology_read(NumaTopology* topology) {
+  memset(topology, 0, sizeof(NumaTopology));
+  for (uint64_t node = 0; ; node++) {
+    char path[MAX_PATH_LENGTH];
+    snprintf(path, sizeof(path), NUMA_SYSFS_NODES "/node%" PRIu64 "/cpulist",
+      node);
+    FILE* file = fopen(path, "r");
+    if (!file) {
+      break;
+    }
+    char list[4096] = "";
+    const bool read = fgets(list, sizeof(list), file) != NULL;
+    fclose(file);
+
+    const uint64_t first_cpu = topology->cpu_count;
+    if (!read || add_cpu_list(topology, list) != EXIT_SUCCESS) {
+      numa_topology_destroy(topology);
+      return EXIT_FAILURE;
+    }
+    if (topology->cpu_count == first_cpu) {
+      continue;
+    }
+    uint64_t* first = (uint64_t*) realloc(topology->first,
+      (topology->node_count + 2) * sizeof(uint64_t));
+    if (!first) {
+      numa_topology_destroy(topology);
+      return EXIT_FAILURE;
+    }
+    topology->first = first;
+    topology->first[topology->node_count++] = first_cpu;
+    topology->first[topology->node_count] = topology->cpu_count;
+  }
+  if (topology->node_count == 0) {
+    numa_topology_destroy(topology);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Libera la memoria de una topología.
+ *
+ * @param topology Topología leída con numa_topology_read.
+ */
+void numa_topology_destroy(NumaTopology* topology) {
+  free(topology->first);
+  free(topology->cpus);
+  memset(topology, 0, sizeof(NumaTopology));
+}
+
+/**
+ * @brief Fija el hilo actual a un CPU según su lugar en el equipo.
+ *
+ * @details Los hilos se reparten entre los nodos en bloques consecutivos, en
+ * el mismo orden que las filas de la lámina, de modo que cada nodo recibe una
+ * franja contigua de la lámina; con dos sockets, cada uno calcula una mitad.
+ * Dentro de un nodo, los hilos ocupan sus CPUs en orden.
+ *
+ * @param topology Topología del equipo.
+ * @param index Posición del hilo en el equipo.
+ * @param thread_count Cantidad de hilos del equipo.
+ * @return EXIT_SUCCESS si el hilo quedó fijo, EXIT_FAILURE si no.
+ */
+int numa_pin_thread(const NumaTopology* topology, uint64_t index,
+  uint64_t thread_count) {
+  const uint64_t node = index * topology->node_count / thread_count;
+  /** Primer hilo del equipo que cae en el mismo nodo. */
+  const uint64_t node_first_thread = (node * thread_count +
+    topology->node_count - 1) / topology->node_count;
+  const uint64_t node_cpus = topology->first[node + 1] - topology->first[node];
+  const int cpu = topology->cpus[topology->first[node] +
+    (index - node_first_thread) % node_cpus];
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0 ?
+    EXIT_SUCCESS : EXIT_FAILURE;
+}
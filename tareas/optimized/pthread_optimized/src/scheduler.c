@@ -0,0 +1,141 @@
+// Copyright 2024 Josué Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+#include "heat_simulation.h"
+
+/** Bits de 'range' que ocupa el siguiente al último bloque pendiente. */
+#define TILE_MASK UINT64_C(0xFFFFFFFF)
+
+/**
+ * @brief Prepara los bloques de una lámina y la cola de cada hilo.
+ *
+ * @details Las filas internas se dividen en STEAL_TILES_PER_THREAD bloques
+ * por hilo, o en una fila por bloque si no alcanzan. Los bloques propios de
+ * cada hilo son contiguos y se reparten de forma equitativa, sin dejar el
+ * residuo al último hilo. Las colas empiezan vacías.
+ *
+ * @param scheduler Planificador a inicializar.
+ * @param rows Número de filas de la lámina.
+ * @param thread_count Número de hilos que calculan los estados.
+ * @return EXIT_SUCCESS si se reservó la memoria, EXIT_FAILURE si no.
+ */
+int tile_scheduler_init(TileScheduler* scheduler, uint64_t rows,
+  uint64_t thread_count) {
+  scheduler->inner_rows = rows > 2 ? rows - 2 : 0;
+  scheduler->deque_count = thread_count;
+  scheduler->tile_count = thread_count * STEAL_TILES_PER_THREAD;
+  if (scheduler->tile_count > scheduler->inner_rows) {
+    scheduler->tile_count = scheduler->inner_rows;
+  }
+  assert(scheduler->tile_count <= TILE_MASK);
+  scheduler->deques = (TileDeque*) aligned_alloc(CACHE_LINE_SIZE,
+    thread_count * sizeof(TileDeque));
+  if (!scheduler->deques) {
+    return EXIT_FAILURE;
+  }
+  for (uint64_t i = 0; i < thread_count; i++) {
+    TileDeque* deque = &scheduler->deques[i];
+    deque->first_tile = scheduler->tile_count * i / thread_count;
+    deque->last_tile = scheduler->tile_count * (i + 1) / thread_count;
+    atomic_init(&deque->range, 0);
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Libera las colas del planificador.
+ *
+ * @param scheduler Planificador a liberar.
+ */
+void tile_scheduler_destroy(TileScheduler* scheduler) {
+  free(scheduler->deques);
+  scheduler->deques = NULL;
+}
+
+/**
+ * @brief Devuelve a cada hilo sus bloques propios para un nuevo estado.
+ *
+ * @details Solo la llama el hilo principal mientras los hilos esperan en la
+ * barrera, que hace visibles las colas antes de que empiece el estado.
+ *
+ * @param scheduler Planificador de la lámina.
+ */
+void tile_scheduler_reset(TileScheduler* scheduler) {
+  for (uint64_t i = 0; i < scheduler->deque_count; i++) {
+    TileDeque* deque = &scheduler->deques[i];
+    atomic_store_explicit(&deque->range, deque->first_tile << 32 |
+      deque->last_tile, memory_order_relaxed);
+  }
+}
+
+/**
+ * @brief Calcula la primera fila de un bloque.
+ *
+ * @param scheduler Planificador de la lámina.
+ * @param tile Bloque, o 'tile_count' para obtener la fila siguiente a la
+ * última interna.
+ * @return Índice de la fila en la matriz.
+ */
+uint64_t tile_scheduler_row(const TileScheduler* scheduler, uint64_t tile) {
+  if (scheduler->tile_count == 0) {
+    return 1;
+  }
+  return 1 + scheduler->inner_rows * tile / scheduler->tile_count;
+}
+
+/**
+ * @brief Toma un bloque de la cola indicada, del frente o del final.
+ *
+ * @param deque Cola de la que se toma el bloque.
+ * @param front true para tomar del frente, como hace el dueño; false para
+ * robar del final.
+ * @param tile Recibe el bloque tomado.
+ * @return true si se tomó un bloque, false si la cola estaba vacía.
+ */
+static bool take_tile(TileDeque* deque, bool front, uint64_t* tile) {
+  uint64_t range = atomic_load_explicit(&deque->range, memory_order_relaxed);
+  while (true) {
+    const uint64_t head = range >> 32;
+    const uint64_t tail = range & TILE_MASK;
+    if (head >= tail) {
+      return false;
+    }
+    const uint64_t next = front ? (head + 1) << 32 | tail :
+      head << 32 | (tail - 1);
+    if (atomic_compare_exchange_weak_explicit(&deque->range, &range, next,
+      memory_order_relaxed, memory_order_relaxed)) {
+      *tile = front ? head : tail - 1;
+      return true;
+    }
+  }
+}
+
+/**
+ * @brief Obtiene el siguiente bloque de filas que debe calcular un hilo.
+ *
+ * @details El hilo toma primero sus bloques propios, en orden. Cuando su cola
+ * se vacía roba del final de las colas de los demás, empezando por el hilo
+ * anterior, cuyos últimos bloques son vecinos de las primeras filas propias.
+ * Las filas se publican a los demás hilos con la barrera del estado, por lo
+ * que las colas no necesitan más orden de memoria que su atomicidad.
+ *
+ * @param scheduler Planificador de la lámina.
+ * @param index Lugar del hilo en el equipo.
+ * @param first_row Recibe la primera fila del bloque.
+ * @param last_row Recibe la fila siguiente a la última del bloque.
+ * @return true si se obtuvo un bloque, false si ya no quedan en el estado.
+ */
+bool tile_scheduler_next(TileScheduler* scheduler, uint64_t index,
+  uint64_t* first_row, uint64_t* last_row) {
+  const uint64_t count = scheduler->deque_count;
+  uint64_t tile = 0;
+  bool found = take_tile(&scheduler->deques[index], true, &tile);
+  for (uint64_t i = 1; !found && i < count; i++) {
+    found = take_tile(&scheduler->deques[(index + count - i) % count], false,
+      &tile);
+  }
+  if (found) {
+    *first_row = tile_scheduler_row(scheduler, tile);
+    *last_row = tile_scheduler_row(scheduler, tile + 1);
+  }
+  return found;
+}
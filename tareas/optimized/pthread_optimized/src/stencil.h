@@ -0,0 +1,37 @@
+// Copyright 2024 Josué Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+#ifndef STENCIL_H
+#define STENCIL_H
+
+#include <stdint.h>
+
+/**
+ * @brief Kernel que calcula una fila del siguiente estado de la lámina.
+ *
+ * @details Calcula las columnas 1 a cols - 2 de 'next' a partir de la fila
+ * 'row' y de sus vecinas 'up' y 'down', donde k = delta_t * alpha / (h * h).
+ * Retorna el mayor cambio absoluto de temperatura dentro de la fila.
+ */
+typedef double (*StencilKernel)(const double* up, const double* row,
+  const double* down, double* next, uint64_t cols, double k);
+
+/**
+ * Los kernels vectoriales (SSE2, AVX2+FMA y AVX-512) coinciden bit a bit con
+ * el kernel escalar, es decir, la tolerancia documentada es 0: cada carril
+ * realiza las mismas operaciones en el mismo orden que el código escalar. FMA
+ * solo se usa para restar 4 * cell, producto que siempre es exacto; usarlo en
+ * la actualización final cambiaría el último bit y con ello los resultados.
+ */
+
+/** Selecciona el kernel según las capacidades del procesador. */
+void stencil_init(void);
+
+/** Calcula una fila con el kernel seleccionado por stencil_init(). */
+double stencil_row(const double* up, const double* row, const double* down,
+  double* next, uint64_t cols, double k);
+
+/** Kernel escalar de referencia. */
+double stencil_row_scalar(const double* up, const double* row,
+  const double* down, double* next, uint64_t cols, double k);
+
+#endif  // STENCIL_H
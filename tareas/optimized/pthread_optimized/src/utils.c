@@ -91,54 +91,6 @@ void create_report(const char* report_file, uint64_t states, const char* time,
   fclose(tsv_file);
 }
 
-/**
- * @brief Escribe el estado final de la placa en un archivo binario.
- * 
- * @param output_dir Directorio donde se escribirá el archivo binario.
- * @param data Datos que representan la placa.
- * @param rows Número de filas en los datos.
- * @param cols Número de columnas en los datos.
- * @param states Número de estados hasta alcanzar el equilibrio.
- * @param plate_filename Nombre del archivo binario asociado con la simulación.
- */
-void write_plate(const char* output_dir, double** data, uint64_t rows,
-  uint64_t cols, uint64_t states, const char* plate_filename) {
-  /** Obtener el número de lámina. */
-  uint64_t plate_number = 0;
-  sscanf(plate_filename, "plate%03lu.bin", &plate_number);
-  /** Crear la ruta al archivo .bin. */
-  char path_to_bin[MAX_PATH_LENGTH];
-  snprintf(path_to_bin, sizeof(path_to_bin), "%s/plate%03lu-%lu.bin",
-    output_dir, plate_number, states);
-
-  FILE* file = fopen(path_to_bin, "wb");
-  if (!file) {
-    perror("Error opening binary file for writing.");
-    return;
-  }
-  /** Escribir el número de filas. */
-  if (fwrite(&rows, sizeof(uint64_t), 1, file) != 1) {
-    perror("Error writing binary rows.");
-    fclose(file);
-    return;
-  }
-  /** Escribir el número de columnas. */
-  if (fwrite(&cols, sizeof(uint64_t), 1, file) != 1) {
-    perror("Error writing binary columns.");
-    fclose(file);
-    return;
-  }
-  /** Escribir las temperaturas. */
-  for (uint64_t i = 0; i < rows; i++) {
-    if (fwrite(data[i], sizeof(double), cols, file) != cols) {
-      perror("Error writing binary data.");
-      fclose(file);
-      return;
-    }
-  }
-  fclose(file);
-}
-
 /**
  * @brief Formatea el tiempo transcurrido en segundos.
  * 
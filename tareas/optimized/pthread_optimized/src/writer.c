@@ -0,0 +1,279 @@
+// Copyright 2024 Josué Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+/** Usar O_DIRECT si el sistema lo ofrece. */
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+
+#include "heat_simulation.h"
+
+/**
+ * @brief Escribe todo el buffer, repitiendo las escrituras parciales.
+ *
+ * @details Si el sistema de archivos rechaza O_DIRECT en la escritura, se
+ * quita la bandera y se repite la escritura con el caché de páginas.
+ *
+ * @param file Descriptor del archivo.
+ * @param buffer Datos a escribir.
+ * @param size Cantidad de bytes.
+ * @param direct Indica si el archivo usa O_DIRECT; se apaga si falla.
+ * @return EXIT_SUCCESS si se escribió todo, EXIT_FAILURE si no.
+ */
+static int write_all(int file, const char* buffer, size_t size,
+  bool* direct) {
+  while (size > 0) {
+    const ssize_t written = write(file, buffer, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+#ifdef O_DIRECT
+      if (errno == EINVAL && *direct) {
+        fcntl(file, F_SETFL, fcntl(file, F_GETFL) & ~O_DIRECT);
+        *direct = false;
+        continue;
+      }
+#endif
+      return EXIT_FAILURE;
+    }
+    buffer += written;
+    size -= (size_t) written;
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Escribe una lámina en un archivo binario con escrituras grandes.
+ *
+ * @details El encabezado y las filas, sin las columnas fantasma, se empacan en
+ * el buffer alineado del escritor y se escriben en bloques de
+ * OUTPUT_CHUNK_BYTES. Con O_DIRECT el último bloque se completa hasta
+ * OUTPUT_ALIGNMENT y luego el archivo se recorta a su tamaño real.
+ *
+ * @param writer Escritor que contiene el buffer alineado.
+ * @param path Ruta del archivo a crear.
+ * @param matrix Lámina a escribir.
+ * @return EXIT_SUCCESS si la operación es exitosa, o EXIT_FAILURE si ocurre
+ * un error.
+ */
+static int stream_plate(OutputWriter* writer, const char* path,
+  const Matrix* matrix) {
+  const int flags = O_WRONLY | O_CREAT | O_TRUNC;
+  bool direct = false;
+  int file = -1;
+#ifdef O_DIRECT
+  file = open(path, flags | O_DIRECT, 0666);
+  direct = file >= 0;
+#endif
+  if (file < 0) {
+    file = open(path, flags, 0666);
+  }
+  if (file < 0) {
+    perror("Error opening binary file for writing.");
+    return EXIT_FAILURE;
+  }
+
+  char* staging = writer->staging;
+  const uint64_t header[2] = {matrix->rows, matrix->cols};
+  memcpy(staging, header, sizeof(header));
+  size_t used = sizeof(header);
+  const size_t row_bytes = matrix->cols * sizeof(double);
+  int error = EXIT_SUCCESS;
+
+  /** Empacar las filas en el buffer y escribirlo cada vez que se llena. */
+  for (uint64_t i = 0; i < matrix->rows && error == EXIT_SUCCESS; i++) {
+    const char* row = (const char*) matrix_row(matrix, i);
+    size_t pending = row_bytes;
+    while (pending > 0 && error == EXIT_SUCCESS) {
+      size_t piece = OUTPUT_CHUNK_BYTES - used;
+      piece = piece < pending ? piece : pending;
+      memcpy(staging + used, row + row_bytes - pending, piece);
+      used += piece;
+      pending -= piece;
+      if (used == OUTPUT_CHUNK_BYTES) {
+        error = write_all(file, staging, used, &direct);
+        used = 0;
+      }
+    }
+  }
+
+  /** Escribir el último bloque, completado hasta OUTPUT_ALIGNMENT. */
+  if (error == EXIT_SUCCESS && used > 0) {
+    size_t size = used;
+    if (direct) {
+      size = (used + OUTPUT_ALIGNMENT - 1) / OUTPUT_ALIGNMENT *
+        OUTPUT_ALIGNMENT;
+      memset(staging + used, 0, size - used);
+    }
+    error = write_all(file, staging, size, &direct);
+    if (error == EXIT_SUCCESS && size != used) {
+      const off_t length = (off_t) (sizeof(header) +
+        matrix->rows * row_bytes);
+      if (ftruncate(file, length) != 0) {
+        error = EXIT_FAILURE;
+      }
+    }
+  }
+  if (close(file) != 0 || error != EXIT_SUCCESS) {
+    perror("Error writing binary data.");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Recuerda un archivo escrito para sincronizarlo al final del trabajo.
+ *
+ * @param writer Escritor de láminas.
+ * @param path Ruta del archivo escrito.
+ */
+static void remember_file(OutputWriter* writer, const char* path) {
+  if (writer->file_count == writer->file_capacity) {
+    const uint64_t capacity = writer->file_capacity ?
+      2 * writer->file_capacity : 16;
+    char** files = (char**) realloc(writer->files, capacity * sizeof(char*));
+    if (!files) {
+      return;
+    }
+    writer->files = files;
+    writer->file_capacity = capacity;
+  }
+  char* copy = strdup(path);
+  if (copy) {
+    writer->files[writer->file_count++] = copy;
+  }
+}
+
+/**
+ * @brief Rutina del hilo escritor.
+ *
+ * @details Toma las láminas de la cola en orden de llegada, las escribe y
+ * libera su memoria. La lámina ocupa su lugar en la cola hasta que termina de
+ * escribirse, de modo que nunca hay más de OUTPUT_QUEUE_CAPACITY láminas
+ * terminadas en memoria.
+ *
+ * @param data Puntero al OutputWriter.
+ * @return NULL
+ */
+static void* run_writer(void* data) {
+  OutputWriter* writer = (OutputWriter*) data;
+  pthread_mutex_lock(&writer->mutex);
+  while (true) {
+    while (writer->count == 0 && !writer->finished) {
+      pthread_cond_wait(&writer->not_empty, &writer->mutex);
+    }
+    if (writer->count == 0) {
+      break;
+    }
+    PlateOutput* output = &writer->queue[writer->head];
+    pthread_mutex_unlock(&writer->mutex);
+
+    if (stream_plate(writer, output->path, &output->matrix) == EXIT_SUCCESS) {
+      remember_file(writer, output->path);
+    }
+    matrix_destroy(&output->matrix);
+
+    pthread_mutex_lock(&writer->mutex);
+    writer->head = (writer->head + 1) % OUTPUT_QUEUE_CAPACITY;
+    writer->count--;
+    pthread_cond_signal(&writer->not_full);
+  }
+  pthread_mutex_unlock(&writer->mutex);
+  return NULL;
+}
+
+/**
+ * @brief Inicia el hilo que escribe las láminas resultantes.
+ *
+ * @param writer Escritor a inicializar.
+ * @return EXIT_SUCCESS si el hilo se creó, o EXIT_FAILURE si ocurre un error.
+ */
+int output_writer_start(OutputWriter* writer) {
+  memset(writer, 0, sizeof(OutputWriter));
+  writer->staging = (char*) aligned_alloc(OUTPUT_ALIGNMENT,
+    OUTPUT_CHUNK_BYTES);
+  if (!writer->staging) {
+    fprintf(stderr, "Could not allocate memory for output buffer.\n");
+    return EXIT_FAILURE;
+  }
+  pthread_mutex_init(&writer->mutex, NULL);
+  pthread_cond_init(&writer->not_empty, NULL);
+  pthread_cond_init(&writer->not_full, NULL);
+  if (pthread_create(&writer->thread, NULL, run_writer, writer) != 0) {
+    fprintf(stderr, "Could not create output writer thread.\n");
+    pthread_mutex_destroy(&writer->mutex);
+    pthread_cond_destroy(&writer->not_empty);
+    pthread_cond_destroy(&writer->not_full);
+    free(writer->staging);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Entrega una lámina terminada al hilo escritor.
+ *
+ * @details El escritor toma posesión de la matriz y la libera después de
+ * escribirla en plateNNN-<states>.bin. Si la cola está llena, espera a que se
+ * libere un lugar.
+ *
+ * @param writer Escritor de láminas.
+ * @param matrix Lámina terminada; queda vacía al retornar.
+ * @param output_dir Directorio donde se escribirá el archivo binario.
+ * @param states Número de estados hasta alcanzar el equilibrio.
+ * @param plate_filename Nombre del archivo binario asociado con la simulación.
+ */
+void output_writer_submit(OutputWriter* writer, Matrix* matrix,
+  const char* output_dir, uint64_t states, const char* plate_filename) {
+  /** Obtener el número de lámina. */
+  uint64_t plate_number = 0;
+  sscanf(plate_filename, "plate%03lu.bin", &plate_number);
+
+  pthread_mutex_lock(&writer->mutex);
+  while (writer->count == OUTPUT_QUEUE_CAPACITY) {
+    pthread_cond_wait(&writer->not_full, &writer->mutex);
+  }
+  PlateOutput* output = &writer->queue[(writer->head + writer->count) %
+    OUTPUT_QUEUE_CAPACITY];
+  output->matrix = *matrix;
+  /** Crear la ruta al archivo .bin. */
+  snprintf(output->path, sizeof(output->path), "%s/plate%03lu-%lu.bin",
+    output_dir, plate_number, states);
+  writer->count++;
+  pthread_cond_signal(&writer->not_empty);
+  pthread_mutex_unlock(&writer->mutex);
+
+  matrix->buffer = NULL;
+  matrix->data = NULL;
+}
+
+/**
+ * @brief Espera a que se escriban todas las láminas y detiene el escritor.
+ *
+ * @details Al final del trabajo sincroniza con el disco cada archivo escrito,
+ * en lugar de hacerlo después de cada lámina.
+ *
+ * @param writer Escritor de láminas.
+ */
+void output_writer_finish(OutputWriter* writer) {
+  pthread_mutex_lock(&writer->mutex);
+  writer->finished = true;
+  pthread_cond_signal(&writer->not_empty);
+  pthread_mutex_unlock(&writer->mutex);
+  pthread_join(writer->thread, NULL);
+
+  for (uint64_t i = 0; i < writer->file_count; i++) {
+    const int file = open(writer->files[i], O_RDONLY);
+    if (file >= 0) {
+      fsync(file);
+      close(file);
+    }
+    free(writer->files[i]);
+  }
+  free(writer->files);
+  free(writer->staging);
+  pthread_mutex_destroy(&writer->mutex);
+  pthread_cond_destroy(&writer->not_empty);
+  pthread_cond_destroy(&writer->not_full);
+}
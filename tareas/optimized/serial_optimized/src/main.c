@@ -18,7 +18,13 @@
  *
  * @details Lee el archivo de trabajo especificado, realiza la simulación de
  * propagación de calor para cada lámina, y genera archivos de reporte y de
- * salida con los resultados.
+ * salida con los resultados. Las láminas se simulan de forma concurrente, una
+ * por hilo, con tantos hilos como indique el cuarto argumento opcional o, si
+ * no se indica, como CPUs disponibles. La opción --precision=float o
+ * --precision=mixed simula con las temperaturas en float; la mixta calcula
+ * cada estado en double y solo guarda en float. Con --compare-double cada
+ * lámina se simula además en double y el reporte indica si la cantidad de
+ * estados cambió.
  *
  * @param argc Número de argumentos de la línea de comandos.
  * @param argv Arreglo de argumentos de la línea de comandos.
@@ -29,25 +35,66 @@ int main(int argc, char* argv[]) {
   struct timespec start_time, finish_time;
   clock_gettime(/*clk_id*/CLOCK_MONOTONIC, &start_time);
 
+  /** Elegir el kernel de la simulación según el procesador. */
+  stencil_init();
+
+  /** Retirar las opciones de precisión de los argumentos. */
+  Precision precision = PRECISION_DOUBLE;
+  bool compare_double = false;
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--", 2) != 0) {
+      continue;
+    }
+    if (strcmp(argv[i], "--precision=double") == 0) {
+      precision = PRECISION_DOUBLE;
+    } else if (strcmp(argv[i], "--precision=float") == 0) {
+      precision = PRECISION_FLOAT;
+    } else if (strcmp(argv[i], "--precision=mixed") == 0) {
+      precision = PRECISION_MIXED;
+    } else if (strcmp(argv[i], "--compare-double") == 0) {
+      compare_double = true;
+    } else {
+      fprintf(stderr, "Invalid option %s.\n", argv[i]);
+      return 13;
+    }
+    for (int j = i; j < argc - 1; j++) {
+      argv[j] = argv[j + 1];
+    }
+    argc--;
+    i--;
+  }
+
   /**
    * Verificar que los argumentos proporcionados en la línea de comandos sean
    * correctos.
    */
-  if (argc < 4 || argc > 4) {
+  if (argc < 4 || argc > 5) {
     /**
      * Si se quiere compilar el programa con el Makefile en el directorio raíz
      * "serial_optimized", se debe correr el programa de la siguiente forma:
-     * bin/serial_optimized job001.txt test/job001/input test/job001/output
+     * bin/serial_optimized job001.txt test/job001/input test/job001/output 4
      *
-     * Los "job" pueden ser reemplazados por el número de job que se desee.
+     * Los "job" pueden ser reemplazados por el número de job que se desee. La
+     * cantidad de hilos es opcional; cada hilo simula una lámina a la vez.
      */
-    fprintf(stderr, "Usage: <job file> <input dir> <output dir>\n");
+    fprintf(stderr, "Usage: <job file> <input dir> <output dir> "
+      "[thread_count] [--precision=double|float|mixed] [--compare-double]\n");
     return 11;
   }
   const char* job_filename = argv[1];
   const char* input_dir = argv[2];
   const char* output_dir = argv[3];
 
+  /** Cantidad de láminas que se simulan a la vez. */
+  uint64_t thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+  if (argc == 5) {
+    if (sscanf(argv[4], "%" SCNu64, &thread_count) != 1 ||
+      thread_count == 0) {
+      fprintf(stderr, "Invalid thread count.\n");
+      return 12;
+    }
+  }
+
   uint64_t job_num = 0;
   sscanf(job_filename, "job%03lu.txt", &job_num);
 
@@ -73,13 +120,59 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
-  const char* plate_filename;
+  uint64_t* states = (uint64_t*) calloc(struct_count, sizeof(uint64_t));
+  int* results = (int*) calloc(struct_count, sizeof(int));
+  /** Estados en double, solo si se comparan con la precisión reducida. */
+  uint64_t* double_states = NULL;
+  if (precision != PRECISION_DOUBLE && compare_double) {
+    double_states = (uint64_t*) calloc(struct_count ? struct_count : 1,
+      sizeof(uint64_t));
+  }
+  if (!states || !results || (compare_double &&
+    precision != PRECISION_DOUBLE && !double_states)) {
+    fprintf(stderr, "Error allocating memory for job results.\n");
+    free(states);
+    free(results);
+    free(double_states);
+    free(simulation_parameters);
+    return 1;
+  }
+
+  /** Ejecutar las simulaciones, varias láminas a la vez. */
+  schedule_job(simulation_parameters, struct_count, input_dir, output_dir,
+    thread_count, precision, states, double_states, results);
+
+  /** Escribir el reporte en el orden del archivo de trabajo. */
   for (uint64_t i = 0; i < struct_count; i++) {
-    plate_filename = simulation_parameters[i].bin_name;
-    /** Ejecutar la simulación. */
-    configure_simulation(plate_filename, simulation_parameters[i], report_path,
-      input_dir, output_dir);
+    if (results[i] != EXIT_SUCCESS) {
+      continue;
+    }
+    const time_t secs = states[i] * simulation_parameters[i].delta_t;
+    char time[49];
+    format_time(secs, time, sizeof(time));
+    /**
+     * En precisión reducida se agrega la precisión y, si se comparó, los
+     * estados en double y si coinciden con los de la simulación.
+     */
+    char note[64];
+    const char* precision_note = NULL;
+    if (precision != PRECISION_DOUBLE) {
+      const char* name = precision == PRECISION_FLOAT ? "float" : "mixed";
+      if (double_states) {
+        snprintf(note, sizeof(note), "%s\t%" PRIu64 "\t%s", name,
+          double_states[i], double_states[i] == states[i] ? "same" :
+          "differs");
+      } else {
+        snprintf(note, sizeof(note), "%s", name);
+      }
+      precision_note = note;
+    }
+    create_report(report_path, states[i], time, simulation_parameters[i],
+      simulation_parameters[i].bin_name, precision_note);
   }
+  free(states);
+  free(results);
+  free(double_states);
 
   /** Tomar el tiempo de finalización. */
   clock_gettime(/*clk_id*/CLOCK_MONOTONIC, &finish_time);
@@ -0,0 +1,294 @@
+// Copyright 2024 Josué Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+/** Proyectar archivos en memoria y usar hilos POSIX. */
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "matrix.h"
+
+/**
+ * @brief Parte de la copia de una lámina que realiza cada hilo.
+ */
+typedef struct load_task {
+  Matrix* matrix;
+  const PlateMap* map;
+  uint64_t start_row, end_row;
+} LoadTask;
+
+/**
+ * @brief Reserva una matriz contigua y alineada a líneas de caché.
+ *
+ * @details El ancho de cada fila se redondea a un múltiplo de una línea de
+ * caché, por lo que todas las filas comienzan en la misma posición relativa a
+ * una línea. Solo se inicializan en cero las columnas fantasma; las columnas
+ * de la lámina quedan sin inicializar hasta que se lean del archivo.
+ *
+ * @param matrix Matriz a inicializar.
+ * @param rows Número de filas de la lámina.
+ * @param cols Número de columnas de la lámina.
+ * @return EXIT_SUCCESS si se reservó la memoria, EXIT_FAILURE si no.
+ */
+int matrix_create(Matrix* matrix, uint64_t rows, uint64_t cols) {
+  matrix->rows = rows;
+  matrix->cols = cols;
+  matrix->stride = (MATRIX_LEAD + cols + 1 + CACHE_LINE_DOUBLES - 1) /
+    CACHE_LINE_DOUBLES * CACHE_LINE_DOUBLES;
+  /** El tamaño del bloque no debe desbordarse. */
+  matrix->buffer = NULL;
+  if (matrix->stride > cols &&
+    rows <= SIZE_MAX / sizeof(double) / matrix->stride) {
+    matrix->buffer = (double*) aligned_alloc(CACHE_LINE_SIZE,
+      rows * matrix->stride * sizeof(double));
+  }
+  if (!matrix->buffer) {
+    matrix->data = NULL;
+    return EXIT_FAILURE;
+  }
+  matrix->data = matrix->buffer + MATRIX_LEAD;
+
+  /** Limpiar las columnas fantasma de cada fila. */
+  const uint64_t tail = matrix->stride - MATRIX_LEAD - cols;
+  for (uint64_t i = 0; i < rows; i++) {
+    double* row = matrix_row(matrix, i);
+    memset(row - MATRIX_LEAD, 0, MATRIX_LEAD * sizeof(double));
+    memset(row + cols, 0, tail * sizeof(double));
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Libera el bloque de memoria de la matriz.
+ *
+ * @param matrix Matriz a liberar.
+ */
+void matrix_destroy(Matrix* matrix) {
+  free(matrix->buffer);
+  matrix->buffer = NULL;
+  matrix->data = NULL;
+}
+
+/**
+ * @brief Reserva una matriz de floats contigua y alineada a líneas de caché.
+ *
+ * @details Sigue las mismas reglas que matrix_create(): las columnas
+ * fantasma quedan en cero y las de la lámina sin inicializar.
+ *
+ * @param matrix Matriz a inicializar.
+ * @param rows Número de filas de la lámina.
+ * @param cols Número de columnas de la lámina.
+ * @return EXIT_SUCCESS si se reservó la memoria, EXIT_FAILURE si no.
+ */
+int float_matrix_create(FloatMatrix* matrix, uint64_t rows, uint64_t cols) {
+  matrix->rows = rows;
+  matrix->cols = cols;
+  matrix->stride = (FLOAT_MATRIX_LEAD + cols + 1 + CACHE_LINE_FLOATS - 1) /
+    CACHE_LINE_FLOATS * CACHE_LINE_FLOATS;
+  /** El tamaño del bloque no debe desbordarse. */
+  matrix->buffer = NULL;
+  if (matrix->stride > cols &&
+    rows <= SIZE_MAX / sizeof(float) / matrix->stride) {
+    matrix->buffer = (float*) aligned_alloc(CACHE_LINE_SIZE,
+      rows * matrix->stride * sizeof(float));
+  }
+  if (!matrix->buffer) {
+    matrix->data = NULL;
+    return EXIT_FAILURE;
+  }
+  matrix->data = matrix->buffer + FLOAT_MATRIX_LEAD;
+
+  /** Limpiar las columnas fantasma de cada fila. */
+  const uint64_t tail = matrix->stride - FLOAT_MATRIX_LEAD - cols;
+  for (uint64_t i = 0; i < rows; i++) {
+    float* row = float_matrix_row(matrix, i);
+    memset(row - FLOAT_MATRIX_LEAD, 0, FLOAT_MATRIX_LEAD * sizeof(float));
+    memset(row + cols, 0, tail * sizeof(float));
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Libera el bloque de memoria de la matriz de floats.
+ *
+ * @param matrix Matriz a liberar.
+ */
+void float_matrix_destroy(FloatMatrix* matrix) {
+  free(matrix->buffer);
+  matrix->buffer = NULL;
+  matrix->data = NULL;
+}
+
+/**
+ * @brief Convierte a float las temperaturas de una matriz de doubles.
+ *
+ * @param matrix Matriz de floats, de las mismas dimensiones que 'source'.
+ * @param source Matriz de doubles.
+ */
+void float_matrix_narrow(FloatMatrix* matrix, const Matrix* source) {
+  for (uint64_t i = 0; i < source->rows; i++) {
+    const double* from = matrix_row(source, i);
+    float* to = float_matrix_row(matrix, i);
+    for (uint64_t j = 0; j < source->cols; j++) {
+      to[j] = (float) from[j];
+    }
+  }
+}
+
+/**
+ * @brief Convierte a double las temperaturas de una matriz de floats.
+ *
+ * @param matrix Matriz de floats.
+ * @param target Matriz de doubles, de las mismas dimensiones que 'matrix'.
+ */
+void float_matrix_widen(const FloatMatrix* matrix, Matrix* target) {
+  for (uint64_t i = 0; i < matrix->rows; i++) {
+    const float* from = float_matrix_row(matrix, i);
+    double* to = matrix_row(target, i);
+    for (uint64_t j = 0; j < matrix->cols; j++) {
+      to[j] = from[j];
+    }
+  }
+}
+
+/**
+ * @brief Copia las filas [start_row, end_row) de la proyección a la matriz.
+ *
+ * @param data Puntero a la tarea LoadTask.
+ * @return NULL
+ */
+static void* load_rows(void* data) {
+  const LoadTask* task = (const LoadTask*) data;
+  const uint64_t cols = task->map->cols;
+  for (uint64_t i = task->start_row; i < task->end_row; i++) {
+    memcpy(matrix_row(task->matrix, i), task->map->cells + i * cols,
+      cols * sizeof(double));
+  }
+  return NULL;
+}
+
+/**
+ * @brief Reserva una matriz y la llena con las temperaturas de una lámina.
+ *
+ * @details Las temperaturas se copian desde la proyección en una sola copia
+ * masiva, repartida por bloques de filas entre 'thread_count' hilos. Si no se
+ * pueden crear los hilos, el hilo actual copia las filas restantes.
+ *
+ * @param matrix Matriz a inicializar.
+ * @param map Archivo de lámina proyectado.
+ * @param thread_count Cantidad de hilos que realizan la copia.
+ * @return EXIT_SUCCESS si se cargó la matriz, EXIT_FAILURE si no.
+ */
+int matrix_load(Matrix* matrix, const PlateMap* map, uint64_t thread_count) {
+  if (matrix_create(matrix, map->rows, map->cols) != EXIT_SUCCESS) {
+    return EXIT_FAILURE;
+  }
+  /** Pedir al kernel que lea todo el archivo por adelantado. */
+  posix_madvise(map->address, map->length, POSIX_MADV_WILLNEED);
+
+  if (thread_count > map->rows) {
+    thread_count = map->rows;
+  }
+  if (thread_count <= 1) {
+    LoadTask task = {matrix, map, 0, map->rows};
+    load_rows(&task);
+    return EXIT_SUCCESS;
+  }
+
+  pthread_t* threads = (pthread_t*) malloc(thread_count * sizeof(pthread_t));
+  LoadTask* tasks = (LoadTask*) malloc(thread_count * sizeof(LoadTask));
+  uint64_t created = 0;
+  const uint64_t rows_per_thread = map->rows / thread_count;
+  for (uint64_t i = 0; threads && tasks && i < thread_count; i++) {
+    tasks[i].matrix = matrix;
+    tasks[i].map = map;
+    tasks[i].start_row = i * rows_per_thread;
+    tasks[i].end_row = i == thread_count - 1 ? map->rows :
+      tasks[i].start_row + rows_per_thread;
+    if (pthread_create(&threads[i], NULL, load_rows, &tasks[i]) != 0) {
+      break;
+    }
+    created++;
+  }
+  /** Copiar en este hilo las filas de los hilos que no se crearon. */
+  if (created < thread_count) {
+    LoadTask rest = {matrix, map, created * rows_per_thread, map->rows};
+    load_rows(&rest);
+  }
+  for (uint64_t i = 0; i < created; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  free(threads);
+  free(tasks);
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Proyecta un archivo de lámina en memoria y valida su encabezado.
+ *
+ * @details El archivo debe contener exactamente el encabezado de 16 bytes más
+ * rows * cols doubles; un archivo truncado o con datos de más se rechaza
+ * antes de leer cualquier temperatura.
+ *
+ * @param map Recibe la proyección.
+ * @param path Ruta del archivo de lámina.
+ * @return EXIT_SUCCESS si se proyectó el archivo, EXIT_FAILURE si no.
+ */
+int plate_map_open(PlateMap* map, const char* path) {
+  memset(map, 0, sizeof(PlateMap));
+  const int file = open(path, O_RDONLY);
+  if (file < 0) {
+    return EXIT_FAILURE;
+  }
+  struct stat info;
+  const uint64_t header_size = 2 * sizeof(uint64_t);
+  if (fstat(file, &info) != 0 || (uint64_t) info.st_size < header_size) {
+    close(file);
+    return EXIT_FAILURE;
+  }
+  void* address = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE,
+    file, 0);
+  close(file);
+  if (address == MAP_FAILED) {
+    return EXIT_FAILURE;
+  }
+
+  /**
+   * Los datos deben coincidir con el encabezado, evitando desbordamientos. Una
+   * lámina sin filas o sin columnas también se rechaza: sus datos vacíos
+   * coincidirían con cualquier valor de la otra dimensión.
+   */
+  const uint64_t* header = (const uint64_t*) address;
+  const uint64_t rows = header[0];
+  const uint64_t cols = header[1];
+  const uint64_t payload = (uint64_t) info.st_size - header_size;
+  if (rows == 0 || cols == 0 || rows > payload / sizeof(double) / cols ||
+    rows * cols * sizeof(double) != payload) {
+    fprintf(stderr, "Plate file %s does not match its header.\n", path);
+    munmap(address, (size_t) info.st_size);
+    return EXIT_FAILURE;
+  }
+
+  map->address = address;
+  map->length = (size_t) info.st_size;
+  map->rows = rows;
+  map->cols = cols;
+  map->cells = (const double*) ((const char*) address + header_size);
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Libera la proyección de un archivo de lámina.
+ *
+ * @param map Proyección a liberar.
+ */
+void plate_map_close(PlateMap* map) {
+  if (map->address) {
+    munmap(map->address, map->length);
+  }
+  memset(map, 0, sizeof(PlateMap));
+}
@@ -0,0 +1,97 @@
+// Copyright 2024 Josué Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Tamaño en bytes de una línea de caché. */
+#define CACHE_LINE_SIZE 64
+
+/** Cantidad de doubles que caben en una línea de caché. */
+#define CACHE_LINE_DOUBLES (CACHE_LINE_SIZE / sizeof(double))
+
+/** Cantidad de floats que caben en una línea de caché. */
+#define CACHE_LINE_FLOATS (CACHE_LINE_SIZE / sizeof(float))
+
+/**
+ * Columnas fantasma antes de la columna 0 de cada fila. Con este valor la
+ * primera columna interna (columna 1) queda alineada a una línea de caché.
+ */
+#define MATRIX_LEAD (CACHE_LINE_DOUBLES - 1)
+
+/** Columnas fantasma antes de la columna 0 de una matriz de floats. */
+#define FLOAT_MATRIX_LEAD (CACHE_LINE_FLOATS - 1)
+
+/**
+ * @brief Matriz de temperaturas almacenada en un solo bloque contiguo.
+ *
+ * @details Todas las filas viven en un único bloque alineado a líneas de
+ * caché. Cada fila ocupa 'stride' doubles: MATRIX_LEAD columnas fantasma, las
+ * 'cols' columnas de la lámina y al menos una columna fantasma al final, con
+ * relleno hasta completar una línea de caché. El elemento (i, j) se encuentra
+ * en data[i * stride + j]. Las columnas fantasma siempre valen cero.
+ */
+typedef struct matrix {
+  double* buffer;    /** Bloque reservado, incluye las columnas fantasma. */
+  double* data;      /** Columna 0 de la fila 0 dentro del bloque. */
+  uint64_t rows, cols;
+  uint64_t stride;   /** Distancia en doubles entre filas consecutivas. */
+} Matrix;
+
+/**
+ * @brief Matriz de temperaturas en precisión simple.
+ *
+ * @details Tiene la misma organización que Matrix, con FLOAT_MATRIX_LEAD
+ * columnas fantasma al inicio de cada fila. Ocupa la mitad de memoria, por lo
+ * que cada estado mueve la mitad de bytes y cada vector procesa el doble de
+ * celdas.
+ */
+typedef struct float_matrix {
+  float* buffer;     /** Bloque reservado, incluye las columnas fantasma. */
+  float* data;       /** Columna 0 de la fila 0 dentro del bloque. */
+  uint64_t rows, cols;
+  uint64_t stride;   /** Distancia en floats entre filas consecutivas. */
+} FloatMatrix;
+
+/**
+ * @brief Archivo de lámina proyectado en memoria.
+ *
+ * @details Un archivo de lámina guarda la cantidad de filas y de columnas como
+ * dos enteros de 8 bytes, seguidos de las temperaturas fila por fila y sin
+ * relleno. La proyección es de solo lectura, por lo que el encabezado y las
+ * temperaturas se pueden recorrer en su lugar sin copiarlos.
+ */
+typedef struct plate_map {
+  void* address;        /** Inicio de la proyección. */
+  size_t length;        /** Tamaño de la proyección en bytes. */
+  uint64_t rows, cols;
+  const double* cells;  /** Temperaturas, rows * cols valores. */
+} PlateMap;
+
+int matrix_create(Matrix* matrix, uint64_t rows, uint64_t cols);
+void matrix_destroy(Matrix* matrix);
+int matrix_load(Matrix* matrix, const PlateMap* map, uint64_t thread_count);
+
+int float_matrix_create(FloatMatrix* matrix, uint64_t rows, uint64_t cols);
+void float_matrix_destroy(FloatMatrix* matrix);
+void float_matrix_narrow(FloatMatrix* matrix, const Matrix* source);
+void float_matrix_widen(const FloatMatrix* matrix, Matrix* target);
+
+int plate_map_open(PlateMap* map, const char* path);
+void plate_map_close(PlateMap* map);
+
+/** Retorna un puntero a la columna 0 de la fila 'row'. */
+static inline double* matrix_row(const Matrix* matrix, uint64_t row) {
+  return matrix->data + row * matrix->stride;
+}
+
+/** Retorna un puntero a la columna 0 de la fila 'row'. */
+static inline float* float_matrix_row(const FloatMatrix* matrix,
+  uint64_t row) {
+  return matrix->data + row * matrix->stride;
+}
+
+#endif  // MATRIX_H
@@ -4,157 +4,251 @@
 
 /**
  * @brief Lee el archivo binario de la placa, crea los datos y llama a las
- * funciones para ejecutar la simulación y escribir los archivos de salida.
+ * funciones para ejecutar la simulación y escribir la lámina resultante.
  *
- * @param plate_filename Nombre del archivo binario que contiene los datos.
- * @param params Estructura que contiene los parámetros de la simulación.
- * @param filepath Ruta donde se guardarán el reporte y los archivos de salida.
+ * @details El archivo se proyecta en memoria y se copia con una sola copia
+ * masiva al bloque de la simulación. Todas las líneas del grupo se atienden
+ * con una sola simulación. El reporte no se escribe aquí: las láminas pueden
+ * simularse en cualquier orden, y el reporte debe conservar el orden del
+ * trabajo. En precisión reducida, si se pide la comparación, la lámina se
+ * vuelve a simular en double sin escribir láminas, solo para contar sus
+ * estados.
+ *
+ * @param params Parámetros de cada línea del archivo de trabajo.
+ * @param group Líneas que comparten lámina, delta_t, alpha y h.
  * @param input_dir Directorio donde se encuentra el archivo binario.
  * @param output_dir Directorio donde se guardará el archivo binario de salida.
+ * @param precision Precisión de la simulación.
+ * @param states Recibe el número de estados hasta el equilibrio de cada línea
+ * del grupo.
+ * @param double_states Si no es NULL, recibe los estados de cada línea del
+ * grupo simulada en double.
+ * @return EXIT_SUCCESS si la lámina se simuló, EXIT_FAILURE si no.
  */
-void configure_simulation(const char* plate_filename, SimData params,
-  const char* filepath, const char* input_dir, const char* output_dir) {
+int configure_simulation(const SimData* params, const SimGroup* group,
+  const char* input_dir, const char* output_dir, Precision precision,
+  uint64_t* states, uint64_t* double_states) {
+  const char* plate_filename = group->params.bin_name;
   /** Crear la ruta hacia el archivo binario. */
   char bin_path[257];
   snprintf(bin_path, sizeof(bin_path), "%s/%s", input_dir, plate_filename);
-  FILE* bin_file;
-  uint64_t rows, cols;
-  bin_file = fopen(bin_path, "rb");
-  if (!bin_file) {
+  /** Proyectar el archivo; su encabezado se valida con el tamaño. */
+  PlateMap plate_map;
+  if (plate_map_open(&plate_map, bin_path) != EXIT_SUCCESS) {
     fprintf(stderr, "Error opening binary file.\n");
-    return;
+    return EXIT_FAILURE;
   }
 
-  /** Leer los valores de la lámina. */
-  if (fread(&rows, sizeof(uint64_t), 1, bin_file) != 1) {
-    fprintf(stderr, "Error reading number of rows.\n");
-    fclose(bin_file);
-    return;
-  }
-  if (fread(&cols, sizeof(uint64_t), 1, bin_file) != 1) {
-    fprintf(stderr, "Error reading number of columns.\n");
-    fclose(bin_file);
-    return;
+  /**
+   * Copiar la lámina a un bloque contiguo y alineado. Las láminas ya se
+   * simulan en paralelo, por lo que la copia la hace este mismo hilo.
+   */
+  Matrix matrix;
+  if (matrix_load(&matrix, &plate_map, 1) != EXIT_SUCCESS) {
+    fprintf(stderr, "Error allocating memory for plate.\n");
+    plate_map_close(&plate_map);
+    return EXIT_FAILURE;
   }
+  plate_map_close(&plate_map);
 
-  double** data = (double**) malloc(rows * sizeof(double*));
-  if (!data) {
-    fprintf(stderr, "Error allocating memory for plate rows.\n");
-    fclose(bin_file);
-    return;
+  /** Epsilons del grupo, de mayor a menor. */
+  double* epsilons = (double*) calloc(group->count, sizeof(double));
+  uint64_t* epsilon_states = (uint64_t*) calloc(group->count,
+    sizeof(uint64_t));
+  if (!epsilons || !epsilon_states) {
+    fprintf(stderr, "Error allocating memory for epsilons.\n");
+    free(epsilons);
+    free(epsilon_states);
+    matrix_destroy(&matrix);
+    return EXIT_FAILURE;
   }
-
-  for (uint64_t i = 0; i < rows; i++) {
-    data[i] = (double*) malloc(cols * sizeof(double));
-    if (!data[i]) {
-      fprintf(stderr, "Error allocating memory for plate columns.\n");
-      for (uint64_t j = 0; j < i; j++) {
-        free(data[j]);
-      }
-      free(data);
-      fclose(bin_file);
-      return;
-    }
+  for (uint64_t i = 0; i < group->count; i++) {
+    epsilons[i] = params[group->lines[i]].epsilon;
   }
 
-  for (uint64_t i = 0; i < rows; i++) {
-    for (uint64_t j = 0; j < cols; j++) {
-      if (fread(&data[i][j], sizeof(double), 1, bin_file) != 1) {
-        fprintf(stderr, "Error reading plate data.\n");
-        for (uint64_t k = 0; k < rows; k++) {
-          free(data[k]);
-        }
-        free(data);
-        fclose(bin_file);
-        return;
-      }
-    }
+  /** Ejecutar una sola simulación para todas las líneas del grupo. */
+  if (precision == PRECISION_DOUBLE) {
+    simulate(&matrix, group->params, epsilons, group->count, epsilon_states,
+      output_dir);
+  } else {
+    simulate_float(&matrix, group->params, epsilons, group->count,
+      epsilon_states, output_dir, precision);
   }
-  fclose(bin_file);
-
-  /** Ejecutar la simulación. */
-  uint64_t states = 0;
-  simulate(data, rows, cols, params, &states);
-
-  /** Tomar el tiempo transcurrido. */
-  const time_t secs = states * params.delta_t;
-  char time[49];
-  format_time(secs, time, sizeof(time));
-
-  /** Escribir la nueva placa. */
-  write_plate(output_dir, data, rows, cols, states, plate_filename);
-  for (uint64_t i = 0; i < rows; i++) {
-    free(data[i]);
+  for (uint64_t i = 0; i < group->count; i++) {
+    states[group->lines[i]] = epsilon_states[i];
+  }
+  if (precision != PRECISION_DOUBLE && double_states) {
+    simulate(&matrix, group->params, epsilons, group->count, epsilon_states,
+      NULL);
+    for (uint64_t i = 0; i < group->count; i++) {
+      double_states[group->lines[i]] = epsilon_states[i];
+    }
   }
-  free(data);
 
-  /** Escribir el reporte. */
-  create_report(filepath, states, time, params, plate_filename);
+  free(epsilons);
+  free(epsilon_states);
+  matrix_destroy(&matrix);
+  return EXIT_SUCCESS;
 }
 
 /**
  * @brief Ejecuta la simulación térmica en cada lámina hasta que se alcance el
  * equilibrio térmico.
  *
- * @param data Datos que representan el estado inicial de la lámina.
- * @param rows Número de filas de la matriz.
- * @param cols Número de columnas de la matriz.
+ * @details Las filas se recorren con aritmética de punteros sobre el bloque
+ * contiguo, de forma que el cálculo avanza linealmente por la memoria. Se usan
+ * dos matrices que intercambian sus papeles en cada estado. La simulación
+ * avanza hasta el equilibrio del menor epsilon; un epsilon mayor alcanza el
+ * equilibrio en un estado anterior de la misma trayectoria, donde se escribe
+ * la lámina correspondiente.
+ *
+ * @param matrix Matriz que representa el estado inicial de la lámina. Al
+ * terminar contiene el estado final.
  * @param params Estructura que contiene los parámetros de la simulación.
- * @param states Puntero para almacenar el número de iteraciones necesarias
- * para alcanzar el equilibrio.
+ * @param epsilons Epsilons de las líneas del grupo, de mayor a menor.
+ * @param epsilon_count Cantidad de epsilons.
+ * @param states Recibe el número de iteraciones necesarias para alcanzar el
+ * equilibrio de cada epsilon.
+ * @param output_dir Directorio donde se guardarán las láminas resultantes;
+ * con NULL no se escriben.
  */
-void simulate(double** data, uint64_t rows, uint64_t cols, SimData params,
-  uint64_t* states) {
-  double** data_copy = (double**) malloc(rows * sizeof(double*));
-  if (!data_copy) {
-    fprintf(stderr, "Error allocating memory for plate copy rows.\n");
+void simulate(Matrix* matrix, SimData params, const double* epsilons,
+  uint64_t epsilon_count, uint64_t* states, const char* output_dir) {
+  const uint64_t rows = matrix->rows;
+  const uint64_t cols = matrix->cols;
+  Matrix copy;
+  if (matrix_create(&copy, rows, cols) != EXIT_SUCCESS) {
+    fprintf(stderr, "Error allocating memory for plate copy.\n");
     return;
   }
-
-  for (uint64_t i = 0; i < rows; i++) {
-    data_copy[i] = (double*) malloc(cols * sizeof(double));
-    if (!data_copy[i]) {
-      fprintf(stderr, "Error allocating memory for data copy.\n");
-      for (uint64_t j = 0; j < i; j++) {
-        free(data_copy[j]);
-      }
-      free(data_copy);
-      return;
-    }
-  }
+  /** Los bordes no cambian, por lo que basta copiarlos una vez. */
+  memcpy(copy.buffer, matrix->buffer, rows * matrix->stride * sizeof(double));
 
   uint64_t state = 0;
-  double max_epsilon = params.epsilon + 1;
-  /** Continuar hasta alcanzar el equilibrio térmico. */
-  while (max_epsilon > params.epsilon) {
+  uint64_t reached = 0;
+  double max_epsilon = 0.0;
+  /** Constante de la fórmula, igual para todas las celdas. */
+  const double factor = params.delta_t * params.alpha / (params.h * params.h);
+  /** Continuar hasta que todos los epsilon alcancen el equilibrio térmico. */
+  while (reached < epsilon_count) {
     max_epsilon = 0.0;
     state++;
     /** Actualizar la temperatura de cada celda con la fórmula. */
     for (uint64_t i = 1; i < rows - 1; i++) {
-      for (uint64_t j = 1; j < cols - 1; j++) {
-        double cell = data[i][j];
-        double cells_around = data[i - 1][j] + data[i][j + 1] + data[i + 1][j]
-          + data[i][j - 1];
-        /** Aplicar la fórmula. */
-        data_copy[i][j] = cell + (params.delta_t * params.alpha / (params.h *
-          params.h)) * (cells_around - 4 * cell);
-        /** Calcular la diferencia máxima. */
-        double difference = fabs(data_copy[i][j] - cell);
-        if (difference > max_epsilon) {
-          max_epsilon = difference;
-        }
+      const double* up = matrix_row(matrix, i - 1);
+      const double* row = matrix_row(matrix, i);
+      const double* down = matrix_row(matrix, i + 1);
+      double* next = matrix_row(&copy, i);
+      /** Aplicar la fórmula y calcular la diferencia máxima de la fila. */
+      double difference = stencil_row(up, row, down, next, cols, factor);
+      if (difference > max_epsilon) {
+        max_epsilon = difference;
       }
     }
-    /** Copiar cambios en la matriz original. */
+    /** Intercambiar las matrices en lugar de copiar los cambios. */
+    Matrix temp = *matrix;
+    *matrix = copy;
+    copy = temp;
+
+    /**
+     * Registrar los epsilon que alcanzaron el equilibrio en este estado y
+     * escribir la lámina una vez por estado.
+     */
+    bool recorded = false;
+    while (reached < epsilon_count && max_epsilon <= epsilons[reached]) {
+      states[reached++] = state;
+      recorded = true;
+    }
+    if (recorded && output_dir) {
+      write_plate(output_dir, matrix, state, params.bin_name);
+    }
+  }
+  matrix_destroy(&copy);
+}
+
+/**
+ * @brief Ejecuta la simulación térmica con las temperaturas en float.
+ *
+ * @details Sigue los mismos pasos que simulate() sobre dos matrices de
+ * floats, que mueven la mitad de bytes por estado. Con PRECISION_MIXED cada
+ * estado se calcula en double y la simulación también termina si la lámina
+ * guardada en float deja de cambiar. Las láminas resultantes se
+ * convierten a double antes de escribirlas, de modo que los archivos de
+ * salida tienen el mismo formato que en double.
+ *
+ * @param matrix Estado inicial de la lámina en double; no se modifica.
+ * @param params Estructura que contiene los parámetros de la simulación.
+ * @param epsilons Epsilons de las líneas del grupo, de mayor a menor.
+ * @param epsilon_count Cantidad de epsilons.
+ * @param states Recibe el número de iteraciones necesarias para alcanzar el
+ * equilibrio de cada epsilon.
+ * @param output_dir Directorio donde se guardarán las láminas resultantes.
+ * @param precision PRECISION_FLOAT o PRECISION_MIXED.
+ */
+void simulate_float(const Matrix* matrix, SimData params,
+  const double* epsilons, uint64_t epsilon_count, uint64_t* states,
+  const char* output_dir, Precision precision) {
+  const uint64_t rows = matrix->rows;
+  const uint64_t cols = matrix->cols;
+  FloatMatrix current = {0}, copy = {0};
+  Matrix output;
+  if (float_matrix_create(&current, rows, cols) != EXIT_SUCCESS ||
+    float_matrix_create(&copy, rows, cols) != EXIT_SUCCESS ||
+    matrix_create(&output, rows, cols) != EXIT_SUCCESS) {
+    fprintf(stderr, "Error allocating memory for float plate.\n");
+    float_matrix_destroy(&current);
+    float_matrix_destroy(&copy);
+    return;
+  }
+  float_matrix_narrow(&current, matrix);
+  /** Los bordes no cambian, por lo que basta copiarlos una vez. */
+  memcpy(copy.buffer, current.buffer, rows * current.stride * sizeof(float));
+
+  uint64_t state = 0;
+  uint64_t reached = 0;
+  /** Constante de la fórmula, igual para todas las celdas. */
+  const float factor = (float) (params.delta_t * params.alpha /
+    (params.h * params.h));
+  while (reached < epsilon_count) {
+    double max_epsilon = 0.0;
+    state++;
     for (uint64_t i = 1; i < rows - 1; i++) {
-      for (uint64_t j = 1; j < cols - 1; j++) {
-        data[i][j] = data_copy[i][j];
+      const float* up = float_matrix_row(&current, i - 1);
+      const float* row = float_matrix_row(&current, i);
+      const float* down = float_matrix_row(&current, i + 1);
+      float* next = float_matrix_row(&copy, i);
+      double difference = precision == PRECISION_MIXED ?
+        stencil_row_mixed(up, row, down, next, cols, factor) :
+        stencil_row_float(up, row, down, next, cols, factor);
+      if (difference > max_epsilon) {
+        max_epsilon = difference;
       }
     }
+    FloatMatrix temp = current;
+    current = copy;
+    copy = temp;
+
+    /**
+     * En precisión mixta el cambio se mide antes de redondear, por lo que no
+     * llega a cero aunque la lámina en float ya no cambie. Si el estado
+     * guardado es igual al anterior, los siguientes también lo son, así que
+     * los epsilon pendientes alcanzan el equilibrio en este estado.
+     */
+    const bool stalled = precision == PRECISION_MIXED &&
+      memcmp(current.buffer, copy.buffer,
+        rows * current.stride * sizeof(float)) == 0;
+    bool recorded = false;
+    while (reached < epsilon_count &&
+      (stalled || max_epsilon <= epsilons[reached])) {
+      states[reached++] = state;
+      recorded = true;
+    }
+    if (recorded) {
+      float_matrix_widen(&current, &output);
+      write_plate(output_dir, &output, state, params.bin_name);
+    }
   }
-  *states = state;
-  for (uint64_t i = 0; i < rows; i++) {
-    free(data_copy[i]);
-  }
-  free(data_copy);
+  float_matrix_destroy(&current);
+  float_matrix_destroy(&copy);
+  matrix_destroy(&output);
 }
@@ -6,11 +6,13 @@
 /** Especificar el tamaño máximo permitido para las rutas de archivos. */
 #define MAX_PATH_LENGTH 1024
 
-/** Medir tiempo de ejecución. */
-#define _POSIX_C_SOURCE 199309L
+/** Medir tiempo de ejecución y usar hilos POSIX. */
+#define _POSIX_C_SOURCE 200809L
 
 #include <inttypes.h>
 #include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -18,6 +20,9 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "matrix.h"
+#include "stencil.h"
+
 /**
  * @brief Estructura que almacena los parámetros de la simulación.
  *
@@ -30,19 +35,56 @@ typedef struct simulation_parameters {
   uint64_t delta_t, h;
 } SimData;
 
+/**
+ * @brief Precisión con la que se guardan y calculan las temperaturas.
+ *
+ * @details Los archivos de lámina siempre guardan doubles: en los modos de
+ * precisión reducida la lámina se convierte a float al cargarla y de vuelta a
+ * double al escribirla.
+ */
+typedef enum precision {
+  PRECISION_DOUBLE,  /** Temperaturas y cálculo en double. */
+  PRECISION_FLOAT,  /** Temperaturas, cálculo y convergencia en float. */
+  PRECISION_MIXED  /** Temperaturas en float; convergencia en double. */
+} Precision;
+
+/**
+ * @brief Líneas del archivo de trabajo que solo difieren en epsilon.
+ *
+ * @details Todas las líneas de un grupo siguen la misma trayectoria, por lo
+ * que se simulan una sola vez. Cada línea alcanza el equilibrio en un prefijo
+ * de la trayectoria de las líneas con un epsilon menor.
+ */
+typedef struct simulation_group {
+  SimData params;  /** Parámetros comunes; epsilon es el menor del grupo. */
+  const uint64_t* lines;  /** Líneas del grupo, de mayor a menor epsilon. */
+  uint64_t count;  /** Cantidad de líneas del grupo. */
+} SimGroup;
+
 /** Declaración de funciones auxiliares en utils.c. */
 uint64_t count_job_lines(FILE* bin_name);
 SimData* read_job_file(const char* job_file, uint64_t* struct_count);
+SimGroup* group_job_lines(const SimData* params, uint64_t count,
+  uint64_t* lines, uint64_t* group_count);
 void create_report(const char* report_file, uint64_t states, const char* time,
-  SimData params, const char* plate_filename);
-void write_plate(const char* output_dir, double** data, uint64_t rows,
-  uint64_t cols, uint64_t states, const char* plate_filename);
+  SimData params, const char* plate_filename, const char* note);
+void write_plate(const char* output_dir, const Matrix* matrix,
+  uint64_t states, const char* plate_filename);
 char* format_time(const time_t seconds, char* text, const size_t capacity);
 
 /** Declaración de funciones relacionadas con la simulación de calor. */
-void configure_simulation(const char* plate_filename, SimData params,
-  const char* filepath, const char* input_dir, const char* output_dir);
-void simulate(double** data, uint64_t rows, uint64_t cols, SimData params,
-  uint64_t* states);
+int configure_simulation(const SimData* params, const SimGroup* group,
+  const char* input_dir, const char* output_dir, Precision precision,
+  uint64_t* states, uint64_t* double_states);
+void simulate(Matrix* matrix, SimData params, const double* epsilons,
+  uint64_t epsilon_count, uint64_t* states, const char* output_dir);
+void simulate_float(const Matrix* matrix, SimData params,
+  const double* epsilons, uint64_t epsilon_count, uint64_t* states,
+  const char* output_dir, Precision precision);
+
+/** Declaración del planificador de trabajos en scheduler.c. */
+void schedule_job(const SimData* params, uint64_t count, const char* input_dir,
+  const char* output_dir, uint64_t thread_count, Precision precision,
+  uint64_t* states, uint64_t* double_states, int* results);
 
 #endif  // PLATE_H
@@ -0,0 +1,203 @@
+// Copyright 2024 Josué Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+#include "plate.h"
+
+/**
+ * @brief Datos compartidos por los hilos del planificador de trabajos.
+ *
+ * @details Los hilos toman grupos de 'order' por medio de 'next', protegido
+ * por 'next_mutex' (mapeo dinámico). Los resultados se guardan en la posición
+ * de cada línea dentro del archivo de trabajo.
+ */
+typedef struct job_scheduler {
+  const SimData* params;
+  const SimGroup* groups;
+  const uint64_t* order;
+  uint64_t count, next;
+  pthread_mutex_t next_mutex;
+  const char* input_dir;
+  const char* output_dir;
+  Precision precision;
+  uint64_t* states;
+  uint64_t* double_states;
+  int* results;
+} JobScheduler;
+
+/**
+ * @brief Costo estimado de una lámina, usado para ordenar las simulaciones.
+ */
+typedef struct plate_cost {
+  double cost;
+  uint64_t index;
+} PlateCost;
+
+/**
+ * @brief Estima el costo de simular una lámina.
+ *
+ * @details Usa el número de celdas, leído en su lugar del encabezado del
+ * archivo proyectado, y una aproximación de la cantidad de estados: crece con
+ * log(1 / epsilon) y disminuye con k = delta_t * alpha / (h * h), que
+ * determina qué tan rápido se difunde el calor. Solo se usa para ordenar, no
+ * necesita ser exacto.
+ *
+ * @param params Parámetros de la lámina.
+ * @param input_dir Directorio donde se encuentra el archivo binario.
+ * @return Costo estimado; 0 si no se pudo leer el encabezado.
+ */
+static double estimate_cost(const SimData* params, const char* input_dir) {
+  char bin_path[MAX_PATH_LENGTH];
+  snprintf(bin_path, sizeof(bin_path), "%s/%s", input_dir, params->bin_name);
+  PlateMap plate_map;
+  if (plate_map_open(&plate_map, bin_path) != EXIT_SUCCESS) {
+    return 0.0;
+  }
+  double cost = (double) plate_map.rows * (double) plate_map.cols;
+  plate_map_close(&plate_map);
+  if (params->epsilon > 0.0 && params->epsilon < 1.0) {
+    cost *= 1.0 - log(params->epsilon);
+  }
+  const double k = params->delta_t * params->alpha /
+    ((double) params->h * params->h);
+  if (k > 0.0) {
+    cost /= k;
+  }
+  return cost;
+}
+
+/**
+ * @brief Compara dos láminas para ordenarlas de mayor a menor costo.
+ *
+ * @details Las láminas con el mismo costo conservan el orden del archivo.
+ */
+static int compare_costs(const void* first, const void* second) {
+  const PlateCost* a = (const PlateCost*) first;
+  const PlateCost* b = (const PlateCost*) second;
+  if (a->cost != b->cost) {
+    return a->cost < b->cost ? 1 : -1;
+  }
+  return a->index < b->index ? -1 : a->index > b->index;
+}
+
+/**
+ * @brief Rutina de cada hilo del planificador.
+ *
+ * @details Toma el siguiente grupo pendiente, lo simula y repite hasta que no
+ * queden grupos.
+ *
+ * @param data Puntero al planificador compartido.
+ * @return NULL
+ */
+static void* run_plates(void* data) {
+  JobScheduler* scheduler = (JobScheduler*) data;
+  while (true) {
+    pthread_mutex_lock(&scheduler->next_mutex);
+    const uint64_t position = scheduler->next++;
+    pthread_mutex_unlock(&scheduler->next_mutex);
+    if (position >= scheduler->count) {
+      break;
+    }
+    const SimGroup* group = &scheduler->groups[scheduler->order[position]];
+    const int result = configure_simulation(scheduler->params, group,
+      scheduler->input_dir, scheduler->output_dir, scheduler->precision,
+      scheduler->states, scheduler->double_states);
+    for (uint64_t i = 0; i < group->count; i++) {
+      scheduler->results[group->lines[i]] = result;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Simula todas las láminas de un trabajo de forma concurrente.
+ *
+ * @details Las líneas que solo difieren en epsilon se agrupan y se simulan una
+ * sola vez. Los grupos se ordenan de mayor a menor costo estimado y se
+ * reparten dinámicamente entre 'thread_count' hilos, de modo que las láminas
+ * más largas empiezan primero y las pequeñas llenan los huecos al final. Los
+ * resultados quedan en el orden del archivo de trabajo para que el reporte
+ * conserve ese orden.
+ *
+ * @param params Parámetros de cada línea del archivo de trabajo.
+ * @param count Número de líneas del archivo de trabajo.
+ * @param input_dir Directorio donde se encuentran los archivos binarios.
+ * @param output_dir Directorio donde se guardarán las láminas resultantes.
+ * @param thread_count Número de láminas que se simulan a la vez.
+ * @param precision Precisión de las simulaciones.
+ * @param states Recibe los estados de cada lámina.
+ * @param double_states Si no es NULL, recibe los estados de cada lámina
+ * simulada en double, para compararlos con los de la precisión reducida.
+ * @param results Recibe EXIT_SUCCESS por cada lámina simulada.
+ */
+void schedule_job(const SimData* params, uint64_t count, const char* input_dir,
+  const char* output_dir, uint64_t thread_count, Precision precision,
+  uint64_t* states, uint64_t* double_states, int* results) {
+  for (uint64_t i = 0; i < count; i++) {
+    results[i] = EXIT_FAILURE;
+  }
+  uint64_t* lines = (uint64_t*) calloc(count ? count : 1, sizeof(uint64_t));
+  uint64_t group_count = 0;
+  SimGroup* groups = lines ?
+    group_job_lines(params, count, lines, &group_count) : NULL;
+  PlateCost* costs = (PlateCost*) calloc(count ? count : 1, sizeof(PlateCost));
+  uint64_t* order = (uint64_t*) calloc(count ? count : 1, sizeof(uint64_t));
+  if (!lines || !groups || !costs || !order) {
+    fprintf(stderr, "Error allocating memory for job scheduler.\n");
+    free(lines);
+    free(groups);
+    free(costs);
+    free(order);
+    return;
+  }
+
+  /**
+   * Ordenar los grupos de mayor a menor costo estimado. Un grupo cuesta lo
+   * mismo que su menor epsilon.
+   */
+  for (uint64_t i = 0; i < group_count; i++) {
+    costs[i].cost = estimate_cost(&groups[i].params, input_dir);
+    costs[i].index = i;
+  }
+  qsort(costs, group_count, sizeof(PlateCost), compare_costs);
+  for (uint64_t i = 0; i < group_count; i++) {
+    order[i] = costs[i].index;
+  }
+  free(costs);
+
+  JobScheduler scheduler = {
+    .params = params, .groups = groups, .order = order,
+    .count = group_count, .next = 0,
+    .input_dir = input_dir, .output_dir = output_dir,
+    .precision = precision, .states = states,
+    .double_states = double_states, .results = results
+  };
+  pthread_mutex_init(&scheduler.next_mutex, NULL);
+
+  /** No crear más hilos que grupos. */
+  if (thread_count > group_count) {
+    thread_count = group_count;
+  }
+  if (thread_count <= 1) {
+    run_plates(&scheduler);
+  } else {
+    pthread_t* threads = (pthread_t*) malloc(thread_count *
+      sizeof(pthread_t));
+    uint64_t created = 0;
+    while (threads && created < thread_count &&
+      pthread_create(&threads[created], NULL, run_plates, &scheduler) == 0) {
+      created++;
+    }
+    /** Si no se pudo crear ningún hilo, el hilo principal hace el trabajo. */
+    if (created == 0) {
+      run_plates(&scheduler);
+    }
+    for (uint64_t i = 0; i < created; i++) {
+      pthread_join(threads[i], NULL);
+    }
+    free(threads);
+  }
+
+  pthread_mutex_destroy(&scheduler.next_mutex);
+  free(order);
+  free(groups);
+  free(lines);
+}
@@ -0,0 +1,489 @@
+// Copyright 2024 Josué Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+#include <math.h>
+
+#include "stencil.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STENCIL_X86
+#endif
+
+/**
+ * @brief Kernel escalar de referencia.
+ *
+ * @details Define el orden de las operaciones que deben respetar los kernels
+ * vectoriales para producir exactamente los mismos resultados.
+ *
+ * @param up Fila superior.
+ * @param row Fila a actualizar.
+ * @param down Fila inferior.
+ * @param next Fila donde se escribe el siguiente estado.
+ * @param cols Número de columnas de la lámina.
+ * @param k Constante delta_t * alpha / (h * h).
+ * @return Mayor cambio absoluto de temperatura en la fila.
+ */
+double stencil_row_scalar(const double* up, const double* row,
+  const double* down, double* next, uint64_t cols, double k) {
+  double max_delta = 0.0;
+  for (uint64_t j = 1; j < cols - 1; j++) {
+    double cell = row[j];
+    double cells_around = up[j] + row[j + 1] + down[j] + row[j - 1];
+    double value = cell + k * (cells_around - 4 * cell);
+    next[j] = value;
+    double delta = fabs(value - cell);
+    if (delta > max_delta) {
+      max_delta = delta;
+    }
+  }
+  return max_delta;
+}
+
+/**
+ * @brief Kernel escalar de referencia en precisión simple.
+ *
+ * @param up Fila superior.
+ * @param row Fila a actualizar.
+ * @param down Fila inferior.
+ * @param next Fila donde se escribe el siguiente estado.
+ * @param cols Número de columnas de la lámina.
+ * @param k Constante delta_t * alpha / (h * h).
+ * @return Mayor cambio absoluto de temperatura en la fila.
+ */
+float stencil_row_float_scalar(const float* up, const float* row,
+  const float* down, float* next, uint64_t cols, float k) {
+  float max_delta = 0.0f;
+  for (uint64_t j = 1; j < cols - 1; j++) {
+    float cell = row[j];
+    float cells_around = up[j] + row[j + 1] + down[j] + row[j - 1];
+    float value = cell + k * (cells_around - 4 * cell);
+    next[j] = value;
+    float delta = fabsf(value - cell);
+    if (delta > max_delta) {
+      max_delta = delta;
+    }
+  }
+  return max_delta;
+}
+
+/**
+ * @brief Kernel escalar de referencia en precisión mixta.
+ *
+ * @details Las temperaturas se leen en float, pero la suma de las vecinas, la
+ * actualización y el cambio de cada celda se calculan en double; el valor
+ * nuevo solo se redondea a float al guardarlo en 'next'.
+ *
+ * @param up Fila superior.
+ * @param row Fila a actualizar.
+ * @param down Fila inferior.
+ * @param next Fila donde se escribe el siguiente estado.
+ * @param cols Número de columnas de la lámina.
+ * @param k Constante delta_t * alpha / (h * h).
+ * @return Mayor cambio absoluto de temperatura en la fila.
+ */
+double stencil_row_mixed_scalar(const float* up, const float* row,
+  const float* down, float* next, uint64_t cols, float k) {
+  const double wide_k = k;
+  double max_delta = 0.0;
+  for (uint64_t j = 1; j < cols - 1; j++) {
+    double cell = row[j];
+    double cells_around = (double) up[j] + row[j + 1] + down[j] + row[j - 1];
+    double value = cell + wide_k * (cells_around - 4 * cell);
+    next[j] = (float) value;
+    double delta = fabs(value - cell);
+    if (delta > max_delta) {
+      max_delta = delta;
+    }
+  }
+  return max_delta;
+}
+
+#ifdef STENCIL_X86
+/** Calcula con el kernel escalar las columnas que no llenan un vector. */
+static double stencil_tail(const double* up, const double* row,
+  const double* down, double* next, uint64_t cols, double k, uint64_t first,
+  double max_delta) {
+  /** El kernel escalar procesa las columnas first a cols - 2. */
+  double tail_delta = stencil_row_scalar(up + first - 1, row + first - 1,
+    down + first - 1, next + first - 1, cols - first + 1, k);
+  return tail_delta > max_delta ? tail_delta : max_delta;
+}
+
+/** Kernel SSE2: dos celdas por instrucción. */
+__attribute__((target("sse2")))
+static double stencil_row_sse2(const double* up, const double* row,
+  const double* down, double* next, uint64_t cols, double k) {
+  const __m128d vk = _mm_set1_pd(k);
+  const __m128d four = _mm_set1_pd(4.0);
+  const __m128d sign = _mm_set1_pd(-0.0);
+  __m128d vmax = _mm_setzero_pd();
+  uint64_t j = 1;
+  for (; j + 2 <= cols - 1; j += 2) {
+    __m128d cell = _mm_loadu_pd(row + j);
+    __m128d up_cell = _mm_loadu_pd(up + j);
+    __m128d down_cell = _mm_loadu_pd(down + j);
+    __m128d left = _mm_loadu_pd(row + j - 1);
+    __m128d right = _mm_loadu_pd(row + j + 1);
+    __m128d cells_around = _mm_add_pd(up_cell, right);
+    cells_around = _mm_add_pd(cells_around, down_cell);
+    cells_around = _mm_add_pd(cells_around, left);
+    __m128d value = _mm_add_pd(cell, _mm_mul_pd(vk,
+      _mm_sub_pd(cells_around, _mm_mul_pd(four, cell))));
+    _mm_storeu_pd(next + j, value);
+    vmax = _mm_max_pd(vmax, _mm_andnot_pd(sign, _mm_sub_pd(value, cell)));
+  }
+  /** Reducir los carriles al máximo de la fila. */
+  vmax = _mm_max_pd(vmax, _mm_unpackhi_pd(vmax, vmax));
+  return stencil_tail(up, row, down, next, cols, k, j, _mm_cvtsd_f64(vmax));
+}
+
+/** Kernel AVX2 con FMA: cuatro celdas por instrucción. */
+__attribute__((target("avx2,fma")))
+static double stencil_row_avx2(const double* up, const double* row,
+  const double* down, double* next, uint64_t cols, double k) {
+  const __m256d vk = _mm256_set1_pd(k);
+  const __m256d four = _mm256_set1_pd(4.0);
+  const __m256d sign = _mm256_set1_pd(-0.0);
+  __m256d vmax = _mm256_setzero_pd();
+  uint64_t j = 1;
+  for (; j + 4 <= cols - 1; j += 4) {
+    __m256d cell = _mm256_loadu_pd(row + j);
+    __m256d up_cell = _mm256_loadu_pd(up + j);
+    __m256d down_cell = _mm256_loadu_pd(down + j);
+    __m256d left = _mm256_loadu_pd(row + j - 1);
+    __m256d right = _mm256_loadu_pd(row + j + 1);
+    __m256d cells_around = _mm256_add_pd(up_cell, right);
+    cells_around = _mm256_add_pd(cells_around, down_cell);
+    cells_around = _mm256_add_pd(cells_around, left);
+    __m256d value = _mm256_add_pd(cell, _mm256_mul_pd(vk,
+      _mm256_fnmadd_pd(four, cell, cells_around)));
+    _mm256_storeu_pd(next + j, value);
+    vmax = _mm256_max_pd(vmax, _mm256_andnot_pd(sign,
+      _mm256_sub_pd(value, cell)));
+  }
+  /** Reducir los carriles al máximo de la fila. */
+  __m128d half = _mm_max_pd(_mm256_castpd256_pd128(vmax),
+    _mm256_extractf128_pd(vmax, 1));
+  half = _mm_max_pd(half, _mm_unpackhi_pd(half, half));
+  return stencil_tail(up, row, down, next, cols, k, j, _mm_cvtsd_f64(half));
+}
+
+/** Kernel AVX-512: ocho celdas por instrucción. */
+__attribute__((target("avx512f")))
+static double stencil_row_avx512(const double* up, const double* row,
+  const double* down, double* next, uint64_t cols, double k) {
+  const __m512d vk = _mm512_set1_pd(k);
+  const __m512d four = _mm512_set1_pd(4.0);
+  __m512d vmax = _mm512_setzero_pd();
+  uint64_t j = 1;
+  for (; j + 8 <= cols - 1; j += 8) {
+    __m512d cell = _mm512_loadu_pd(row + j);
+    __m512d up_cell = _mm512_loadu_pd(up + j);
+    __m512d down_cell = _mm512_loadu_pd(down + j);
+    __m512d left = _mm512_loadu_pd(row + j - 1);
+    __m512d right = _mm512_loadu_pd(row + j + 1);
+    __m512d cells_around = _mm512_add_pd(up_cell, right);
+    cells_around = _mm512_add_pd(cells_around, down_cell);
+    cells_around = _mm512_add_pd(cells_around, left);
+    __m512d value = _mm512_add_pd(cell, _mm512_mul_pd(vk,
+      _mm512_fnmadd_pd(four, cell, cells_around)));
+    _mm512_storeu_pd(next + j, value);
+    vmax = _mm512_max_pd(vmax, _mm512_abs_pd(_mm512_sub_pd(value, cell)));
+  }
+  return stencil_tail(up, row, down, next, cols, k, j,
+    _mm512_reduce_max_pd(vmax));
+}
+/** Calcula en float con el kernel escalar las columnas que sobran. */
+static float stencil_tail_float(const float* up, const float* row,
+  const float* down, float* next, uint64_t cols, float k, uint64_t first,
+  float max_delta) {
+  float tail_delta = stencil_row_float_scalar(up + first - 1, row + first - 1,
+    down + first - 1, next + first - 1, cols - first + 1, k);
+  return tail_delta > max_delta ? tail_delta : max_delta;
+}
+
+/** Calcula en precisión mixta con el kernel escalar las columnas que sobran. */
+static double stencil_tail_mixed(const float* up, const float* row,
+  const float* down, float* next, uint64_t cols, float k, uint64_t first,
+  double max_delta) {
+  double tail_delta = stencil_row_mixed_scalar(up + first - 1, row + first - 1,
+    down + first - 1, next + first - 1, cols - first + 1, k);
+  return tail_delta > max_delta ? tail_delta : max_delta;
+}
+
+/** Calcula el siguiente estado de cuatro celdas en float con SSE2. */
+__attribute__((target("sse2")))
+static inline __m128 stencil_cells_sse2(const float* up, const float* row,
+  const float* down, float* next, uint64_t j, __m128 vk) {
+  const __m128 four = _mm_set1_ps(4.0f);
+  __m128 cell = _mm_loadu_ps(row + j);
+  __m128 cells_around = _mm_add_ps(_mm_loadu_ps(up + j),
+    _mm_loadu_ps(row + j + 1));
+  cells_around = _mm_add_ps(cells_around, _mm_loadu_ps(down + j));
+  cells_around = _mm_add_ps(cells_around, _mm_loadu_ps(row + j - 1));
+  __m128 value = _mm_add_ps(cell, _mm_mul_ps(vk,
+    _mm_sub_ps(cells_around, _mm_mul_ps(four, cell))));
+  _mm_storeu_ps(next + j, value);
+  return value;
+}
+
+/** Kernel SSE2 en float: cuatro celdas por instrucción. */
+__attribute__((target("sse2")))
+static float stencil_row_float_sse2(const float* up, const float* row,
+  const float* down, float* next, uint64_t cols, float k) {
+  const __m128 vk = _mm_set1_ps(k);
+  const __m128 sign = _mm_set1_ps(-0.0f);
+  __m128 vmax = _mm_setzero_ps();
+  uint64_t j = 1;
+  for (; j + 4 <= cols - 1; j += 4) {
+    __m128 value = stencil_cells_sse2(up, row, down, next, j, vk);
+    vmax = _mm_max_ps(vmax, _mm_andnot_ps(sign,
+      _mm_sub_ps(value, _mm_loadu_ps(row + j))));
+  }
+  /** Reducir los carriles al máximo de la fila. */
+  vmax = _mm_max_ps(vmax, _mm_movehl_ps(vmax, vmax));
+  vmax = _mm_max_ss(vmax, _mm_shuffle_ps(vmax, vmax, 1));
+  return stencil_tail_float(up, row, down, next, cols, k, j,
+    _mm_cvtss_f32(vmax));
+}
+
+/** Carga dos floats consecutivos como doubles. */
+__attribute__((target("sse2")))
+static inline __m128d load_wide_sse2(const float* cells) {
+  return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(
+    (const __m128i*) cells)));
+}
+
+/** Kernel SSE2 en precisión mixta: dos celdas en double por instrucción. */
+__attribute__((target("sse2")))
+static double stencil_row_mixed_sse2(const float* up, const float* row,
+  const float* down, float* next, uint64_t cols, float k) {
+  const __m128d vk = _mm_set1_pd(k);
+  const __m128d four = _mm_set1_pd(4.0);
+  const __m128d sign = _mm_set1_pd(-0.0);
+  __m128d vmax = _mm_setzero_pd();
+  uint64_t j = 1;
+  for (; j + 2 <= cols - 1; j += 2) {
+    __m128d cell = load_wide_sse2(row + j);
+    __m128d cells_around = _mm_add_pd(load_wide_sse2(up + j),
+      load_wide_sse2(row + j + 1));
+    cells_around = _mm_add_pd(cells_around, load_wide_sse2(down + j));
+    cells_around = _mm_add_pd(cells_around, load_wide_sse2(row + j - 1));
+    __m128d value = _mm_add_pd(cell, _mm_mul_pd(vk,
+      _mm_sub_pd(cells_around, _mm_mul_pd(four, cell))));
+    /** Redondear a float solo al guardar. */
+    _mm_storel_pi((__m64*) (next + j), _mm_cvtpd_ps(value));
+    vmax = _mm_max_pd(vmax, _mm_andnot_pd(sign, _mm_sub_pd(value, cell)));
+  }
+  vmax = _mm_max_pd(vmax, _mm_unpackhi_pd(vmax, vmax));
+  return stencil_tail_mixed(up, row, down, next, cols, k, j,
+    _mm_cvtsd_f64(vmax));
+}
+
+/** Calcula el siguiente estado de ocho celdas en float con AVX2 y FMA. */
+__attribute__((target("avx2,fma")))
+static inline __m256 stencil_cells_avx2(const float* up, const float* row,
+  const float* down, float* next, uint64_t j, __m256 vk) {
+  const __m256 four = _mm256_set1_ps(4.0f);
+  __m256 cell = _mm256_loadu_ps(row + j);
+  __m256 cells_around = _mm256_add_ps(_mm256_loadu_ps(up + j),
+    _mm256_loadu_ps(row + j + 1));
+  cells_around = _mm256_add_ps(cells_around, _mm256_loadu_ps(down + j));
+  cells_around = _mm256_add_ps(cells_around, _mm256_loadu_ps(row + j - 1));
+  __m256 value = _mm256_add_ps(cell, _mm256_mul_ps(vk,
+    _mm256_fnmadd_ps(four, cell, cells_around)));
+  _mm256_storeu_ps(next + j, value);
+  return value;
+}
+
+/** Kernel AVX2 con FMA en float: ocho celdas por instrucción. */
+__attribute__((target("avx2,fma")))
+static float stencil_row_float_avx2(const float* up, const float* row,
+  const float* down, float* next, uint64_t cols, float k) {
+  const __m256 vk = _mm256_set1_ps(k);
+  const __m256 sign = _mm256_set1_ps(-0.0f);
+  __m256 vmax = _mm256_setzero_ps();
+  uint64_t j = 1;
+  for (; j + 8 <= cols - 1; j += 8) {
+    __m256 value = stencil_cells_avx2(up, row, down, next, j, vk);
+    vmax = _mm256_max_ps(vmax, _mm256_andnot_ps(sign,
+      _mm256_sub_ps(value, _mm256_loadu_ps(row + j))));
+  }
+  /** Reducir los carriles al máximo de la fila. */
+  __m128 half = _mm_max_ps(_mm256_castps256_ps128(vmax),
+    _mm256_extractf128_ps(vmax, 1));
+  half = _mm_max_ps(half, _mm_movehl_ps(half, half));
+  half = _mm_max_ss(half, _mm_shuffle_ps(half, half, 1));
+  return stencil_tail_float(up, row, down, next, cols, k, j,
+    _mm_cvtss_f32(half));
+}
+
+/** Kernel AVX2 con FMA en precisión mixta: cuatro celdas en double. */
+__attribute__((target("avx2,fma")))
+static double stencil_row_mixed_avx2(const float* up, const float* row,
+  const float* down, float* next, uint64_t cols, float k) {
+  const __m256d vk = _mm256_set1_pd(k);
+  const __m256d four = _mm256_set1_pd(4.0);
+  const __m256d sign = _mm256_set1_pd(-0.0);
+  __m256d vmax = _mm256_setzero_pd();
+  uint64_t j = 1;
+  for (; j + 4 <= cols - 1; j += 4) {
+    __m256d cell = _mm256_cvtps_pd(_mm_loadu_ps(row + j));
+    __m256d cells_around = _mm256_add_pd(_mm256_cvtps_pd(_mm_loadu_ps(up + j)),
+      _mm256_cvtps_pd(_mm_loadu_ps(row + j + 1)));
+    cells_around = _mm256_add_pd(cells_around,
+      _mm256_cvtps_pd(_mm_loadu_ps(down + j)));
+    cells_around = _mm256_add_pd(cells_around,
+      _mm256_cvtps_pd(_mm_loadu_ps(row + j - 1)));
+    __m256d value = _mm256_add_pd(cell, _mm256_mul_pd(vk,
+      _mm256_fnmadd_pd(four, cell, cells_around)));
+    /** Redondear a float solo al guardar. */
+    _mm_storeu_ps(next + j, _mm256_cvtpd_ps(value));
+    vmax = _mm256_max_pd(vmax, _mm256_andnot_pd(sign,
+      _mm256_sub_pd(value, cell)));
+  }
+  __m128d half = _mm_max_pd(_mm256_castpd256_pd128(vmax),
+    _mm256_extractf128_pd(vmax, 1));
+  half = _mm_max_pd(half, _mm_unpackhi_pd(half, half));
+  return stencil_tail_mixed(up, row, down, next, cols, k, j,
+    _mm_cvtsd_f64(half));
+}
+
+/** Calcula el siguiente estado de dieciséis celdas en float con AVX-512. */
+__attribute__((target("avx512f")))
+static inline __m512 stencil_cells_avx512(const float* up, const float* row,
+  const float* down, float* next, uint64_t j, __m512 vk) {
+  const __m512 four = _mm512_set1_ps(4.0f);
+  __m512 cell = _mm512_loadu_ps(row + j);
+  __m512 cells_around = _mm512_add_ps(_mm512_loadu_ps(up + j),
+    _mm512_loadu_ps(row + j + 1));
+  cells_around = _mm512_add_ps(cells_around, _mm512_loadu_ps(down + j));
+  cells_around = _mm512_add_ps(cells_around, _mm512_loadu_ps(row + j - 1));
+  __m512 value = _mm512_add_ps(cell, _mm512_mul_ps(vk,
+    _mm512_fnmadd_ps(four, cell, cells_around)));
+  _mm512_storeu_ps(next + j, value);
+  return value;
+}
+
+/** Kernel AVX-512 en float: dieciséis celdas por instrucción. */
+__attribute__((target("avx512f")))
+static float stencil_row_float_avx512(const float* up, const float* row,
+  const float* down, float* next, uint64_t cols, float k) {
+  const __m512 vk = _mm512_set1_ps(k);
+  __m512 vmax = _mm512_setzero_ps();
+  uint64_t j = 1;
+  for (; j + 16 <= cols - 1; j += 16) {
+    __m512 value = stencil_cells_avx512(up, row, down, next, j, vk);
+    vmax = _mm512_max_ps(vmax, _mm512_abs_ps(_mm512_sub_ps(value,
+      _mm512_loadu_ps(row + j))));
+  }
+  return stencil_tail_float(up, row, down, next, cols, k, j,
+    _mm512_reduce_max_ps(vmax));
+}
+
+/** Kernel AVX-512 en precisión mixta: ocho celdas en double. */
+__attribute__((target("avx512f")))
+static double stencil_row_mixed_avx512(const float* up, const float* row,
+  const float* down, float* next, uint64_t cols, float k) {
+  const __m512d vk = _mm512_set1_pd(k);
+  const __m512d four = _mm512_set1_pd(4.0);
+  __m512d vmax = _mm512_setzero_pd();
+  uint64_t j = 1;
+  for (; j + 8 <= cols - 1; j += 8) {
+    __m512d cell = _mm512_cvtps_pd(_mm256_loadu_ps(row + j));
+    __m512d cells_around = _mm512_add_pd(
+      _mm512_cvtps_pd(_mm256_loadu_ps(up + j)),
+      _mm512_cvtps_pd(_mm256_loadu_ps(row + j + 1)));
+    cells_around = _mm512_add_pd(cells_around,
+      _mm512_cvtps_pd(_mm256_loadu_ps(down + j)));
+    cells_around = _mm512_add_pd(cells_around,
+      _mm512_cvtps_pd(_mm256_loadu_ps(row + j - 1)));
+    __m512d value = _mm512_add_pd(cell, _mm512_mul_pd(vk,
+      _mm512_fnmadd_pd(four, cell, cells_around)));
+    /** Redondear a float solo al guardar. */
+    _mm256_storeu_ps(next + j, _mm512_cvtpd_ps(value));
+    vmax = _mm512_max_pd(vmax, _mm512_abs_pd(_mm512_sub_pd(value, cell)));
+  }
+  return stencil_tail_mixed(up, row, down, next, cols, k, j,
+    _mm512_reduce_max_pd(vmax));
+}
+#endif
+
+/** Kernel seleccionado; el escalar mientras no se llame stencil_init(). */
+static StencilKernel stencil_kernel = stencil_row_scalar;
+static StencilKernelFloat stencil_kernel_float = stencil_row_float_scalar;
+static StencilKernelMixed stencil_kernel_mixed = stencil_row_mixed_scalar;
+
+/**
+ * @brief Selecciona el kernel más ancho que soporta el procesador.
+ *
+ * @details Consulta cpuid por medio de __builtin_cpu_supports. Debe llamarse
+ * una vez al iniciar el programa, antes de crear hilos.
+ */
+void stencil_init(void) {
+#ifdef STENCIL_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    stencil_kernel = stencil_row_avx512;
+    stencil_kernel_float = stencil_row_float_avx512;
+    stencil_kernel_mixed = stencil_row_mixed_avx512;
+  } else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    stencil_kernel = stencil_row_avx2;
+    stencil_kernel_float = stencil_row_float_avx2;
+    stencil_kernel_mixed = stencil_row_mixed_avx2;
+  } else if (__builtin_cpu_supports("sse2")) {
+    stencil_kernel = stencil_row_sse2;
+    stencil_kernel_float = stencil_row_float_sse2;
+    stencil_kernel_mixed = stencil_row_mixed_sse2;
+  }
+#endif
+}
+
+/**
+ * @brief Calcula una fila del siguiente estado con el kernel seleccionado.
+ *
+ * @param up Fila superior.
+ * @param row Fila a actualizar.
+ * @param down Fila inferior.
+ * @param next Fila donde se escribe el siguiente estado.
+ * @param cols Número de columnas de la lámina.
+ * @param k Constante delta_t * alpha / (h * h).
+ * @return Mayor cambio absoluto de temperatura en la fila.
+ */
+double stencil_row(const double* up, const double* row, const double* down,
+  double* next, uint64_t cols, double k) {
+  return stencil_kernel(up, row, down, next, cols, k);
+}
+
+/**
+ * @brief Calcula una fila en float con el kernel seleccionado.
+ *
+ * @param up Fila superior.
+ * @param row Fila a actualizar.
+ * @param down Fila inferior.
+ * @param next Fila donde se escribe el siguiente estado.
+ * @param cols Número de columnas de la lámina.
+ * @param k Constante delta_t * alpha / (h * h).
+ * @return Mayor cambio absoluto de temperatura en la fila.
+ */
+float stencil_row_float(const float* up, const float* row, const float* down,
+  float* next, uint64_t cols, float k) {
+  return stencil_kernel_float(up, row, down, next, cols, k);
+}
+
+/**
+ * @brief Calcula una fila en float, con el cambio en double, con el kernel
+ * seleccionado.
+ *
+ * @param up Fila superior.
+ * @param row Fila a actualizar.
+ * @param down Fila inferior.
+ * @param next Fila donde se escribe el siguiente estado.
+ * @param cols Número de columnas de la lámina.
+ * @param k Constante delta_t * alpha / (h * h).
+ * @return Mayor cambio absoluto de temperatura en la fila.
+ */
+double stencil_row_mixed(const float* up, const float* row,
+  const float* down, float* next, uint64_t cols, float k) {
+  return stencil_kernel_mixed(up, row, down, next, cols, k);
+}
@@ -0,0 +1,73 @@
+// Copyright 2024 Josué Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+#ifndef STENCIL_H
+#define STENCIL_H
+
+#include <stdint.h>
+
+/**
+ * @brief Kernel que calcula una fila del siguiente estado de la lámina.
+ *
+ * @details Calcula las columnas 1 a cols - 2 de 'next' a partir de la fila
+ * 'row' y de sus vecinas 'up' y 'down', donde k = delta_t * alpha / (h * h).
+ * Retorna el mayor cambio absoluto de temperatura dentro de la fila.
+ */
+typedef double (*StencilKernel)(const double* up, const double* row,
+  const double* down, double* next, uint64_t cols, double k);
+
+/**
+ * @brief Kernel en precisión simple.
+ *
+ * @details Igual que StencilKernel, con las temperaturas y el cálculo en
+ * float. Retorna el mayor cambio absoluto calculado en float.
+ */
+typedef float (*StencilKernelFloat)(const float* up, const float* row,
+  const float* down, float* next, uint64_t cols, float k);
+
+/**
+ * @brief Kernel en precisión mixta.
+ *
+ * @details Lee las temperaturas en float como StencilKernelFloat, pero
+ * calcula el siguiente estado y el cambio de cada celda en double; el valor
+ * nuevo solo se redondea a float al guardarlo, de modo que ni la
+ * actualización ni la métrica de convergencia pierden precisión.
+ */
+typedef double (*StencilKernelMixed)(const float* up, const float* row,
+  const float* down, float* next, uint64_t cols, float k);
+
+/**
+ * Los kernels vectoriales (SSE2, AVX2+FMA y AVX-512) coinciden bit a bit con
+ * el kernel escalar, es decir, la tolerancia documentada es 0: cada carril
+ * realiza las mismas operaciones en el mismo orden que el código escalar. FMA
+ * solo se usa para restar 4 * cell, producto que siempre es exacto; usarlo en
+ * la actualización final cambiaría el último bit y con ello los resultados.
+ * Lo mismo vale para los kernels en float y mixtos respecto a sus kernels
+ * escalares.
+ */
+
+/** Selecciona el kernel según las capacidades del procesador. */
+void stencil_init(void);
+
+/** Calcula una fila con el kernel seleccionado por stencil_init(). */
+double stencil_row(const double* up, const double* row, const double* down,
+  double* next, uint64_t cols, double k);
+
+/** Kernel escalar de referencia. */
+double stencil_row_scalar(const double* up, const double* row,
+  const double* down, double* next, uint64_t cols, double k);
+
+/** Calcula una fila en float con el kernel seleccionado. */
+float stencil_row_float(const float* up, const float* row, const float* down,
+  float* next, uint64_t cols, float k);
+
+/** Calcula en double una fila guardada en float. */
+double stencil_row_mixed(const float* up, const float* row,
+  const float* down, float* next, uint64_t cols, float k);
+
+/** Kernels escalares de referencia en precisión simple y mixta. */
+float stencil_row_float_scalar(const float* up, const float* row,
+  const float* down, float* next, uint64_t cols, float k);
+double stencil_row_mixed_scalar(const float* up, const float* row,
+  const float* down, float* next, uint64_t cols, float k);
+
+#endif  // STENCIL_H
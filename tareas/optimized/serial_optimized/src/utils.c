@@ -69,6 +69,65 @@ SimData* read_job_file(const char* job_file, uint64_t* struct_count) {
   return simulation_parameters;
 }
 
+/**
+ * @brief Agrupa las líneas del archivo de trabajo que solo difieren en
+ * epsilon.
+ * 
+ * @details Las líneas con la misma lámina, delta_t, alpha y h siguen la misma
+ * trayectoria, por lo que cada grupo se simula una sola vez. Las líneas de
+ * cada grupo quedan seguidas en 'lines', de mayor a menor epsilon; las líneas
+ * con el mismo epsilon conservan el orden del archivo.
+ * 
+ * @param params Parámetros de cada línea del archivo de trabajo.
+ * @param count Número de líneas del archivo de trabajo.
+ * @param lines Arreglo de 'count' elementos que recibe las líneas de cada
+ * grupo. Los grupos apuntan a él, por lo que debe existir mientras se usen.
+ * @param group_count Puntero para almacenar la cantidad de grupos.
+ * @return Arreglo de grupos, o NULL si no se pudo reservar memoria.
+ */
+SimGroup* group_job_lines(const SimData* params, uint64_t count,
+  uint64_t* lines, uint64_t* group_count) {
+  *group_count = 0;
+  SimGroup* groups = (SimGroup*) calloc(count ? count : 1, sizeof(SimGroup));
+  bool* grouped = (bool*) calloc(count ? count : 1, sizeof(bool));
+  if (!groups || !grouped) {
+    perror("Error allocating memory for simulation groups.");
+    free(groups);
+    free(grouped);
+    return NULL;
+  }
+  uint64_t used = 0;
+  for (uint64_t i = 0; i < count; i++) {
+    if (grouped[i]) {
+      continue;
+    }
+    SimGroup* group = &groups[(*group_count)++];
+    uint64_t* group_lines = &lines[used];
+    for (uint64_t j = i; j < count; j++) {
+      if (grouped[j] || strcmp(params[j].bin_name, params[i].bin_name) != 0 ||
+        params[j].delta_t != params[i].delta_t ||
+        params[j].alpha != params[i].alpha || params[j].h != params[i].h) {
+        continue;
+      }
+      /** Insertar la línea después de las de epsilon mayor o igual. */
+      uint64_t position = group->count++;
+      while (position > 0 &&
+        params[group_lines[position - 1]].epsilon < params[j].epsilon) {
+        group_lines[position] = group_lines[position - 1];
+        position--;
+      }
+      group_lines[position] = j;
+      grouped[j] = true;
+    }
+    group->lines = group_lines;
+    group->params = params[i];
+    group->params.epsilon = params[group_lines[group->count - 1]].epsilon;
+    used += group->count;
+  }
+  free(grouped);
+  return groups;
+}
+
 /**
  * @brief Escribe los resultados de la simulación en un archivo de reporte.
  * 
@@ -77,17 +136,22 @@ SimData* read_job_file(const char* job_file, uint64_t* struct_count) {
  * @param time Tiempo transcurrido en la simulación.
  * @param params Estructura que contiene el contenido del archivo de trabajo.
  * @param plate_filename Nombre del archivo binario asociado con la simulación.
+ * @param note Columnas adicionales al final de la línea, o NULL.
  */
 void create_report(const char* report_file, uint64_t states, const char* time,
-  SimData params, const char* plate_filename) {
+  SimData params, const char* plate_filename, const char* note) {
   FILE* tsv_file = fopen(report_file, "a");
   if (!tsv_file) {
     perror("Error opening report file.");
     return;
   }
   /** Escribir el reporte. */
-  fprintf(tsv_file, "%s\t%ld\t%g\t%ld\t%g\t%lu\t%s\n", plate_filename,
+  fprintf(tsv_file, "%s\t%ld\t%g\t%ld\t%g\t%lu\t%s", plate_filename,
     params.delta_t, params.alpha, params.h, params.epsilon, states, time);
+  if (note) {
+    fprintf(tsv_file, "\t%s", note);
+  }
+  fputc('\n', tsv_file);
   fclose(tsv_file);
 }
 
@@ -95,14 +159,14 @@ void create_report(const char* report_file, uint64_t states, const char* time,
  * @brief Escribe el estado final de la placa en un archivo binario.
  * 
  * @param output_dir Directorio donde se escribirá el archivo binario.
- * @param data Datos que representan la placa.
- * @param rows Número de filas en los datos.
- * @param cols Número de columnas en los datos.
+ * @param matrix Matriz contigua que representa la placa.
  * @param states Número de estados hasta alcanzar el equilibrio.
  * @param plate_filename Nombre del archivo binario asociado con la simulación.
  */
-void write_plate(const char* output_dir, double** data, uint64_t rows,
-  uint64_t cols, uint64_t states, const char* plate_filename) {
+void write_plate(const char* output_dir, const Matrix* matrix,
+  uint64_t states, const char* plate_filename) {
+  const uint64_t rows = matrix->rows;
+  const uint64_t cols = matrix->cols;
   /** Obtener el número de lámina. */
   uint64_t plate_number = 0;
   sscanf(plate_filename, "plate%03lu.bin", &plate_number);
@@ -130,7 +194,7 @@ void write_plate(const char* output_dir, double** data, uint64_t rows,
   }
   /** Escribir las temperaturas. */
   for (uint64_t i = 0; i < rows; i++) {
-    if (fwrite(data[i], sizeof(double), cols, file) != cols) {
+    if (fwrite(matrix_row(matrix, i), sizeof(double), cols, file) != cols) {
       perror("Error writing binary data.");
       fclose(file);
       return;
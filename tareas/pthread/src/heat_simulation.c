@@ -59,36 +59,21 @@ void configure_simulation(const char* dir, SimData* sim_params, uint64_t lines,
       return;
     }
 
-    shared_data->data = malloc(shared_data->rows * sizeof(double*));
-    if (shared_data->data == NULL) {
-      fprintf(stderr, "Error allocating memory for plate rows\n");
+    /** Reservar la lámina en un único bloque contiguo y alineado. */
+    if (matrix_create(&shared_data->data, shared_data->rows,
+      shared_data->cols) != EXIT_SUCCESS) {
+      fprintf(stderr, "Error allocating memory for plate\n");
       fclose(file);  /** Cerrar el archivo para evitar pérdidas de memoria. */
       return;
     }
-    for (uint64_t i = 0; i < shared_data->rows; i++) {
-      shared_data->data[i] = malloc(shared_data->cols * sizeof(double));
-      if (shared_data->data[i] == NULL) {
-        fprintf(stderr, "Error allocating memory for plate cols\n");
-        /** Liberar memoria si ocurre un error. */
-        for (uint64_t j = 0; j < i; j++) {
-          free(shared_data->data[j]);
-        }
-        free(shared_data->data);
-        fclose(file);
-        return;
-      }
-    }
     /** Leer los datos de la lámina. */
     for (uint64_t i = 0; i < shared_data->rows; i++) {
-      if (fread(shared_data->data[i], sizeof(double), shared_data->cols, file)
-        != shared_data->cols) {
+      if (fread(matrix_row(&shared_data->data, i), sizeof(double),
+        shared_data->cols, file) != shared_data->cols) {
         fprintf(stderr, "Error reading plate data: %s\n",
           sim_params[i].bin_name);
         /** Si ocurre un error, libera la memoria y cierra el archivo. */
-        for (uint64_t j = 0; j < shared_data->rows; j++) {
-          free(shared_data->data[j]);
-        }
-        free(shared_data->data);
+        matrix_destroy(&shared_data->data);
         fclose(file);
         return;
       }
@@ -108,13 +93,9 @@ void configure_simulation(const char* dir, SimData* sim_params, uint64_t lines,
     sim_states[i] = num_states;
 
     /** Escribir los resultados de la simulación en un archivo binario. */
-    write_plate(shared_data->data, shared_data->rows, shared_data->cols, dir,
-      sim_params[i].bin_name, num_states);
+    write_plate(&shared_data->data, dir, sim_params[i].bin_name, num_states);
     /** Liberar la memoria asignada a los datos de la lámina. */
-    for (uint64_t j = 0; j < shared_data->rows; j++) {
-      free(shared_data->data[j]);
-    }
-    free(shared_data->data);
+    matrix_destroy(&shared_data->data);
     fclose(file);
   }
 
@@ -132,8 +113,13 @@ void configure_simulation(const char* dir, SimData* sim_params, uint64_t lines,
  * 
  * @details Esta función coordina la simulación del calor en una lámina
  * representada por una matriz de datos. La matriz se divide en secciones que
- * son procesadas en paralelo por varios hilos. La simulación continúa hasta
- * que se alcanza el equilibrio térmico.
+ * son procesadas en paralelo por varios hilos. Los hilos se crean una sola vez
+ * y cada estado se delimita con dos esperas en la barrera compartida: la
+ * primera libera a los hilos para calcular el estado y la segunda indica que
+ * todos terminaron. Cada hilo revisa el equilibrio de sus filas mientras las
+ * calcula, por lo que entre estados el hilo principal solamente combina un
+ * resultado por hilo e intercambia las dos matrices, sin recorrer la lámina,
+ * copiar datos ni reservar memoria.
  * 
  * @param shared_data Puntero a la estructura que contiene los parámetros y la
  * matriz compartida de la simulación.
@@ -151,68 +137,85 @@ uint64_t simulate(SharedData* shared_data, uint64_t thread_count) {
   uint64_t num_states = 0;
   bool eq_point = false;
 
-  /** Bucle que ejecuta la simulación hasta alcanzar el equilibrio térmico. */
-  while (!eq_point) {
-    num_states++;  /** Se incrementa el número de iteraciones. */
-    eq_point = true;
-    /** Crear una copia local de la matriz de datos compartida. */
-    double data_local[shared_data->rows][shared_data->cols];
-    for (uint64_t i = 0; i < shared_data->rows; i++) {
-      for (uint64_t j = 0; j < shared_data->cols; j++) {
-        data_local[i][j] = shared_data->data[i][j];
-      }
-    }
+  /**
+   * Segunda matriz para el siguiente estado. Se copia una sola vez para que
+   * los bordes, que nunca cambian, sean iguales en ambas matrices.
+   */
+  if (matrix_create(&shared_data->next_data, shared_data->rows,
+    shared_data->cols) != EXIT_SUCCESS) {
+    fprintf(stderr, "Error allocating memory for plate copy\n");
+    return num_states;
+  }
+  memcpy(shared_data->next_data.buffer, shared_data->data.buffer,
+    shared_data->rows * shared_data->data.stride * sizeof(double));
 
-    /** Asignación de filas a cada hilo y creación de los hilos. */
-    for (uint64_t i = 0; i < thread_count; i++) {
-      /** Calcula el número de filas que manejará cada hilo. */
-      uint64_t rows_per_thread = (shared_data->rows - 2) / thread_count;
+  /** La barrera incluye a los hilos de trabajo y al hilo principal. */
+  pthread_barrier_init(&shared_data->step_barrier, NULL, thread_count + 1);
+  shared_data->finished = false;
 
-      /** Asignar la fila de inicio para el hilo 'i'. */
-      thread_data[i].start_row = 1 + i * rows_per_thread;
+  /** Asignación de filas a cada hilo y creación de los hilos. */
+  for (uint64_t i = 0; i < thread_count; i++) {
+    /** Calcula el número de filas que manejará cada hilo. */
+    uint64_t rows_per_thread = (shared_data->rows - 2) / thread_count;
 
-      /** Asignar la fila de finalización. */
-      if (i == thread_count - 1) {
-        /** El último hilo maneja hasta la última fila. */
-        thread_data[i].end_row = shared_data->rows - 1;
-      } else {
-        thread_data[i].end_row = thread_data[i].start_row + rows_per_thread;
-      }
-      thread_data[i].shared_data = shared_data;
+    /** Asignar la fila de inicio para el hilo 'i'. */
+    thread_data[i].start_row = 1 + i * rows_per_thread;
 
-      /** Crear el hilo, ejecutando la función para actualizar la matriz. */
-      pthread_create(&threads[i], NULL, thread_sim, &thread_data[i]);
+    /** Asignar la fila de finalización. */
+    if (i == thread_count - 1) {
+      /** El último hilo maneja hasta la última fila. */
+      thread_data[i].end_row = shared_data->rows - 1;
+    } else {
+      thread_data[i].end_row = thread_data[i].start_row + rows_per_thread;
     }
+    thread_data[i].shared_data = shared_data;
 
-    /** Esperar a que todos los hilos terminen su ejecución. */
-    for (uint64_t i = 0; i < thread_count; i++) {
-      pthread_join(threads[i], NULL);
-    }
+    /** Crear el hilo, que queda esperando el inicio del primer estado. */
+    pthread_create(&threads[i], NULL, thread_sim, &thread_data[i]);
+  }
+
+  /** Bucle que ejecuta la simulación hasta alcanzar el equilibrio térmico. */
+  while (!eq_point) {
+    num_states++;  /** Se incrementa el número de iteraciones. */
+    eq_point = true;
+
+    /** Liberar a los hilos y esperar a que terminen el estado actual. */
+    pthread_barrier_wait(&shared_data->step_barrier);
+    pthread_barrier_wait(&shared_data->step_barrier);
 
-    /** Comprobar si se ha alcanzado el equilibrio térmico. */
-    for (uint64_t i = 1; i < shared_data->rows - 1; i++) {
-      for (uint64_t j = 1; j < shared_data->cols - 1; j++) {
-        double temperature = data_local[i][j];
-        double next_temp = shared_data->data[i][j];
-        if (fabs(next_temp - temperature) >= shared_data->epsilon) {
-          eq_point = false;  /** Se actualiza la bandera de equilibrio. */
-          break;
-        }
+    /** Combinar el resultado de equilibrio que calculó cada hilo. */
+    for (uint64_t i = 0; i < thread_count; i++) {
+      if (!thread_data[i].equilibrium) {
+        eq_point = false;  /** Se actualiza la bandera de equilibrio. */
+        break;
       }
     }
+
+    /** El nuevo estado pasa a ser el actual. */
+    Matrix temp = shared_data->data;
+    shared_data->data = shared_data->next_data;
+    shared_data->next_data = temp;
+  }
+  /** Indicar a los hilos que terminen y esperar a que salgan. */
+  shared_data->finished = true;
+  pthread_barrier_wait(&shared_data->step_barrier);
+  for (uint64_t i = 0; i < thread_count; i++) {
+    pthread_join(threads[i], NULL);
   }
+  pthread_barrier_destroy(&shared_data->step_barrier);
+
+  matrix_destroy(&shared_data->next_data);
   /** Retornar el número de estados necesarios para alcanzar el equilibrio. */
   return num_states;
 }
 
 /**
- * @brief Función que ejecuta la simulación de calor para una sección de la
- * matriz.
+ * @brief Rutina de cada hilo del equipo de simulación.
  * 
- * @details Esta función es llamada por cada hilo para procesar una parte de la
- * matriz compartida, calculando las nuevas temperaturas basadas en las celdas
- * vecinas. Cada hilo trabaja en un subconjunto de filas de la matriz, asignado
- * a través de la estructura 'ThreadData'.
+ * @details El hilo vive durante toda la simulación de una lámina. En cada
+ * estado espera en la barrera a que el hilo principal lo libere, calcula sus
+ * filas y vuelve a esperar en la barrera para indicar que terminó. Sale cuando
+ * el hilo principal marca 'finished'.
  * 
  * @param data Puntero a la estructura que contiene la información específica
  * del hilo, como las filas que debe procesar y un puntero a los datos
@@ -222,41 +225,56 @@ void* thread_sim(void* data) {
   ThreadData* private_data = (ThreadData*) data;
   SharedData* shared_data = private_data->shared_data;
 
-  /** Crear una copia temporal de la matriz para actualizar los valores. */
-  double** temp_data = malloc(shared_data->rows * sizeof(double*));
-  for (uint64_t i = 0; i < shared_data->rows; i++) {
-    temp_data[i] = malloc(shared_data->cols * sizeof(double));
+  while (true) {
+    /** Esperar a que el hilo principal inicie un nuevo estado. */
+    pthread_barrier_wait(&shared_data->step_barrier);
+    if (shared_data->finished) {
+      break;
+    }
+    simulate_rows(private_data);
+    /** Avisar que las filas de este hilo ya están actualizadas. */
+    pthread_barrier_wait(&shared_data->step_barrier);
   }
+  return NULL;  /** Finalizar la ejecución del hilo. */
+}
+
+/**
+ * @brief Calcula un estado de la simulación para una sección de la matriz.
+ * 
+ * @details Procesa una parte de la matriz compartida, calculando las nuevas
+ * temperaturas basadas en las celdas vecinas. Cada hilo trabaja en un
+ * subconjunto de filas de la matriz, asignado a través de la estructura
+ * 'ThreadData'. Lee el estado actual de 'data' y escribe el siguiente
+ * directamente en 'next_data', por lo que los hilos no necesitan copias
+ * temporales. Al mismo tiempo determina si sus filas alcanzaron el equilibrio
+ * y lo deja en 'private_data->equilibrium'.
+ * 
+ * @param private_data Información del hilo: filas que debe procesar y puntero
+ * a los datos compartidos.
+ */
+void simulate_rows(ThreadData* private_data) {
+  SharedData* shared_data = private_data->shared_data;
+  bool equilibrium = true;
+  /** Constante de la fórmula, igual para todas las celdas. */
+  const double factor = (shared_data->delta_t * shared_data->alpha) /
+    (shared_data->h * shared_data->h);
+
   /**
    * Procesar las filas asignadas a este hilo. Cada hilo maneja una parte de
    * las filas de la matriz.
    */
   for (uint64_t i = private_data->start_row; i < private_data->end_row; i++) {
-    for (uint64_t j = 1; j < shared_data->cols - 1; j++) {
-      /** Obtener el valor actual de la celda en la posición [i][j]. */
-      double temperature = shared_data->data[i][j];
-
-      /** Calcular la nueva temperatura usando la fórmula. */
-      double next_temp = temperature + ((shared_data->delta_t *
-        shared_data->alpha) / (shared_data->h * shared_data->h)) *
-          (shared_data->data[i - 1][j] + shared_data->data[i + 1][j] +
-            shared_data->data[i][j - 1] + shared_data->data[i][j + 1] - 4 *
-              temperature);
-      /** Guardar el valor calculado en la copia temporal de la matriz. */
-      temp_data[i][j] = next_temp;
-    }
-  }
-
-  /** Copiar los resultados de la matriz temporal a la matriz compartida. */
-  for (uint64_t i = private_data->start_row; i < private_data->end_row; i++) {
-    for (uint64_t j = 1; j < shared_data->cols - 1; j++) {
-      shared_data->data[i][j] = temp_data[i][j];
+    const double* up = matrix_row(&shared_data->data, i - 1);
+    const double* row = matrix_row(&shared_data->data, i);
+    const double* down = matrix_row(&shared_data->data, i + 1);
+    double* next = matrix_row(&shared_data->next_data, i);
+    /** Calcular la fila completa con el kernel vectorial disponible. */
+    double max_delta = stencil_row(up, row, down, next, shared_data->cols,
+      factor);
+    if (max_delta >= shared_data->epsilon) {
+      equilibrium = false;
     }
   }
-  /** Liberar la memoria de la copia de la matriz. */
-  for (uint64_t i = 0; i < shared_data->rows; i++) {
-    free(temp_data[i]);
-  }
-  free(temp_data);
-  return NULL;  /** Finalizar la ejecución del hilo. */
+  /** Publicar el resultado; la barrera lo hace visible al hilo principal. */
+  private_data->equilibrium = equilibrium;
 }
@@ -6,8 +6,8 @@
 /** Especificar el tamaño máximo permitido para las rutas de archivos. */
 #define MAX_PATH_LENGTH 1024
 
-/** Medir tiempo de ejecución. */
-#define _POSIX_C_SOURCE 199309L
+/** Medir tiempo de ejecución y usar barreras de pthreads. */
+#define _POSIX_C_SOURCE 200809L
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -20,6 +20,9 @@
 #include <inttypes.h>
 #include <unistd.h>
 
+#include "matrix.h"  // NOLINT
+#include "stencil.h"  // NOLINT
+
 /**
  * @brief Estructura que almacena los parámetros de la simulación.
  * 
@@ -36,21 +39,30 @@ typedef struct simulation_parameters {
  * simulación.
  * 
  * @details Contiene la información de la lámina y sus propiedades, así como la
- * matriz de datos que representa las temperaturas de cada celda.
+ * matriz de datos que representa las temperaturas de cada celda. El equipo de
+ * hilos se crea una sola vez por lámina y avanza de estado en estado
+ * sincronizado por 'step_barrier'; 'finished' indica a los hilos que terminen.
+ * 'data' guarda el estado actual y 'next_data' recibe el siguiente; ambas
+ * matrices intercambian sus papeles al final de cada estado.
  */
 typedef struct shared_thread_data {
-  double** data;
+  Matrix data, next_data;
   uint64_t cols, rows;
   double delta_t, alpha, h, epsilon;
+  pthread_barrier_t step_barrier;
+  bool finished;
 } SharedData;
 
 /**
  * @brief Estructura que almacena los datos privados para cada hilo.
  * 
  * @details Esta estructura define el rango de filas que un hilo debe procesar
- * durante la simulación.
+ * durante la simulación. Cada hilo escribe en 'equilibrium' si sus filas
+ * alcanzaron el equilibrio en el último estado; el campo ocupa su propia
+ * línea de caché para que los hilos no compartan líneas al escribirlo.
  */
 typedef struct private_thread_data {
+  _Alignas(CACHE_LINE_SIZE) bool equilibrium;
   uint64_t start_row, end_row;
   SharedData* shared_data;
 } ThreadData;
@@ -60,13 +72,14 @@ void configure_simulation(const char* dir, SimData* sim_params, uint64_t lines,
   const char* job_name, uint64_t thread_count);
 uint64_t simulate(SharedData* shared_data, uint64_t thread_count);
 void* thread_sim(void* data);
+void simulate_rows(ThreadData* private_data);
 
 /** Declaración de funciones de lectura y escritura en utils.c. */
 SimData* read_job_file(const char* job_name, const char* dir, uint64_t* lines);
 void create_report(const char* dir, const char* job_name, SimData* sim_params,
   uint64_t* sim_states, uint64_t lines);
-void write_plate(double** data, uint64_t rows, uint64_t cols, const char* dir,
-  const char* job_name, uint64_t num_states);
+void write_plate(const Matrix* data, const char* dir, const char* job_name,
+  uint64_t num_states);
 char* format_time(const time_t seconds, char* text, const size_t capacity);
 uint64_t count_job_lines(const char* bin_name);
 
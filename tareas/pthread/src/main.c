@@ -38,6 +38,9 @@ int main(int argc, char* argv[]) {
   struct timespec start_time, finish_time;
   clock_gettime(/*clk_id*/CLOCK_MONOTONIC, &start_time);
 
+  /** Elegir el kernel de la simulación según el procesador. */
+  stencil_init();
+
   const char* job_name = argv[2];
   const char* dir = argv[3];
   uint64_t thread_count = sysconf(_SC_NPROCESSORS_ONLN);
@@ -0,0 +1,50 @@
+// Copyright 2024 Josué Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+#include "matrix.h"  // NOLINT
+
+/**
+ * @brief Reserva una matriz contigua y alineada a líneas de caché.
+ *
+ * @details El ancho de cada fila se redondea a un múltiplo de una línea de
+ * caché, por lo que todas las filas comienzan en la misma posición relativa a
+ * una línea. Solo se inicializan en cero las columnas fantasma; las columnas
+ * de la lámina quedan sin inicializar hasta que se lean del archivo.
+ *
+ * @param matrix Matriz a inicializar.
+ * @param rows Número de filas de la lámina.
+ * @param cols Número de columnas de la lámina.
+ * @return EXIT_SUCCESS si se reservó la memoria, EXIT_FAILURE si no.
+ */
+int matrix_create(Matrix* matrix, uint64_t rows, uint64_t cols) {
+  matrix->rows = rows;
+  matrix->cols = cols;
+  matrix->stride = (MATRIX_LEAD + cols + 1 + CACHE_LINE_DOUBLES - 1) /
+    CACHE_LINE_DOUBLES * CACHE_LINE_DOUBLES;
+  matrix->buffer = (double*) aligned_alloc(CACHE_LINE_SIZE,
+    rows * matrix->stride * sizeof(double));
+  if (!matrix->buffer) {
+    matrix->data = NULL;
+    return EXIT_FAILURE;
+  }
+  matrix->data = matrix->buffer + MATRIX_LEAD;
+
+  /** Limpiar las columnas fantasma de cada fila. */
+  const uint64_t tail = matrix->stride - MATRIX_LEAD - cols;
+  for (uint64_t i = 0; i < rows; i++) {
+    double* row = matrix_row(matrix, i);
+    memset(row - MATRIX_LEAD, 0, MATRIX_LEAD * sizeof(double));
+    memset(row + cols, 0, tail * sizeof(double));
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Libera el bloque de memoria de la matriz.
+ *
+ * @param matrix Matriz a liberar.
+ */
+void matrix_destroy(Matrix* matrix) {
+  free(matrix->buffer);
+  matrix->buffer = NULL;
+  matrix->data = NULL;
+}
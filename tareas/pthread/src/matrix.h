@@ -0,0 +1,46 @@
+// Copyright 2024 Josué Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+#ifndef TAREAS_PTHREAD_SRC_MATRIX_H
+#define TAREAS_PTHREAD_SRC_MATRIX_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Tamaño en bytes de una línea de caché. */
+#define CACHE_LINE_SIZE 64
+
+/** Cantidad de doubles que caben en una línea de caché. */
+#define CACHE_LINE_DOUBLES (CACHE_LINE_SIZE / sizeof(double))
+
+/**
+ * Columnas fantasma antes de la columna 0 de cada fila. Con este valor la
+ * primera columna interna (columna 1) queda alineada a una línea de caché.
+ */
+#define MATRIX_LEAD (CACHE_LINE_DOUBLES - 1)
+
+/**
+ * @brief Matriz de temperaturas almacenada en un solo bloque contiguo.
+ *
+ * @details Todas las filas viven en un único bloque alineado a líneas de
+ * caché. Cada fila ocupa 'stride' doubles: MATRIX_LEAD columnas fantasma, las
+ * 'cols' columnas de la lámina y al menos una columna fantasma al final, con
+ * relleno hasta completar una línea de caché. El elemento (i, j) se encuentra
+ * en data[i * stride + j]. Las columnas fantasma siempre valen cero.
+ */
+typedef struct matrix {
+  double* buffer;    /** Bloque reservado, incluye las columnas fantasma. */
+  double* data;      /** Columna 0 de la fila 0 dentro del bloque. */
+  uint64_t rows, cols;
+  uint64_t stride;   /** Distancia en doubles entre filas consecutivas. */
+} Matrix;
+
+int matrix_create(Matrix* matrix, uint64_t rows, uint64_t cols);
+void matrix_destroy(Matrix* matrix);
+
+/** Retorna un puntero a la columna 0 de la fila 'row'. */
+static inline double* matrix_row(const Matrix* matrix, uint64_t row) {
+  return matrix->data + row * matrix->stride;
+}
+
+#endif  // TAREAS_PTHREAD_SRC_MATRIX_H
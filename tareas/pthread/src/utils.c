@@ -155,15 +155,15 @@ void create_report(const char* dir, const char* job_name, SimData* sim_params,
  * un archivo binario. El archivo se nombra usando el nombre del trabajo y el
  * número de estados transcurridos.
  * 
- * @param data Matriz de datos que contiene los valores de la simulación.
- * @param rows Número de filas de la matriz.
- * @param cols Número de columnas de la matriz.
+ * @param data Matriz contigua que contiene los valores de la simulación.
  * @param dir Directorio donde se guardará el archivo binario.
  * @param job_name Nombre del trabajo.
  * @param num_states Número de estados transcurridos en la simulación.
  */
-void write_plate(double** data, uint64_t rows, uint64_t cols, const char* dir,
-  const char* job_name, uint64_t num_states) {
+void write_plate(const Matrix* data, const char* dir, const char* job_name,
+  uint64_t num_states) {
+  const uint64_t rows = data->rows;
+  const uint64_t cols = data->cols;
   char file_name[MAX_PATH_LENGTH];
   char base_name[512];
   /** Copiar el nombre del archivo. */
@@ -182,7 +182,7 @@ void write_plate(double** data, uint64_t rows, uint64_t cols, const char* dir,
   fwrite(&rows, sizeof(uint64_t), 1, output_file);
   fwrite(&cols, sizeof(uint64_t), 1, output_file);
   for (uint64_t i = 0; i < rows; i++) {
-    fwrite(data[i], sizeof(double), cols, output_file);
+    fwrite(matrix_row(data, i), sizeof(double), cols, output_file);
   }
   fclose(output_file);
 }
@@ -0,0 +1,268 @@
+// Copyright 2024 Josué Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+#include "plate.h"
+
+/**
+ * @brief Construye la ruta del archivo de punto de control de un trabajo.
+ *
+ * @details El archivo se llama como el archivo de trabajo, con la extensión
+ * .ckpt, y se guarda en el directorio de salida junto al reporte.
+ *
+ * @param path Arreglo donde se escribe la ruta.
+ * @param capacity Capacidad del arreglo.
+ * @param job_file Ruta del archivo de trabajo.
+ * @param output_dir Directorio de salida.
+ * @return EXIT_SUCCESS si la ruta cabe en el arreglo, EXIT_FAILURE si no.
+ */
+int checkpoint_path(char* path, size_t capacity, const char* job_file,
+  const char* output_dir) {
+  const char* base_name = strrchr(job_file, '/');
+  base_name = base_name ? base_name + 1 : job_file;
+  const char* dot_position = strrchr(base_name, '.');
+  const int base_length = dot_position ? (int) (dot_position - base_name) :
+    (int) strlen(base_name);
+  int written = snprintf(path, capacity, "%s/%.*s.ckpt", output_dir,
+    base_length, base_name);
+  if (written < 0 || (size_t) written >= capacity) {
+    fprintf(stderr, "Error: the checkpoint path is too long\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Escribe un punto de control de forma atómica.
+ *
+ * @details Los datos se escriben en un archivo temporal que se sincroniza con
+ * el disco y luego reemplaza al anterior con rename(), de modo que siempre
+ * existe un punto de control completo aunque el proceso muera a la mitad.
+ *
+ * @param path Ruta del archivo de punto de control.
+ * @param header Encabezado del punto de control.
+ * @param matrix Lámina; solo se escribe si 'rows' es mayor que 0.
+ * @param rows Número de filas que se escriben.
+ * @param cols Número de columnas que se escriben.
+ * @return EXIT_SUCCESS si la operación es exitosa, o EXIT_FAILURE si ocurre
+ * un error.
+ */
+static int write_checkpoint(const char* path, const CheckpointHeader* header,
+  const Matrix* matrix, uint64_t rows, uint64_t cols) {
+  char temp_path[MAX_PATH_LENGTH + 4];
+  snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+  FILE* file = fopen(temp_path, "wb");
+  if (file == NULL) {
+    perror("Error opening the checkpoint file");
+    return EXIT_FAILURE;
+  }
+
+  /** Encabezado, dimensiones y temperaturas, como en los archivos de lámina. */
+  bool written = fwrite(header, sizeof(CheckpointHeader), 1, file) == 1 &&
+    fwrite(&rows, sizeof(uint64_t), 1, file) == 1 &&
+    fwrite(&cols, sizeof(uint64_t), 1, file) == 1;
+  for (uint64_t i = 0; written && i < rows; i++) {
+    written = fwrite(matrix_row(matrix, i), sizeof(double), cols, file) ==
+      cols;
+  }
+  written = written && fflush(file) == 0 && fsync(fileno(file)) == 0;
+  if (fclose(file) != 0 || !written) {
+    perror("Error writing the checkpoint file");
+    remove(temp_path);
+    return EXIT_FAILURE;
+  }
+  if (rename(temp_path, path) != 0) {
+    perror("Error replacing the checkpoint file");
+    remove(temp_path);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Rutina del hilo que escribe los puntos de control.
+ *
+ * @details Espera a que haya un punto de control pendiente y lo escribe fuera
+ * de la sección crítica. Antes de terminar escribe el último que quede
+ * pendiente.
+ *
+ * @param data Puntero al CheckpointWriter.
+ * @return NULL
+ */
+static void* run_writer(void* data) {
+  CheckpointWriter* writer = (CheckpointWriter*) data;
+  pthread_mutex_lock(&writer->mutex);
+  while (true) {
+    while (!writer->pending && !writer->finished) {
+      pthread_cond_wait(&writer->cond, &writer->mutex);
+    }
+    if (!writer->pending) {
+      break;
+    }
+    writer->pending = false;
+    writer->busy = true;
+    pthread_mutex_unlock(&writer->mutex);
+
+    /** La copia no cambia mientras 'busy' sea verdadero. */
+    write_checkpoint(writer->path, &writer->header, &writer->snapshot,
+      writer->rows, writer->cols);
+
+    pthread_mutex_lock(&writer->mutex);
+    writer->busy = false;
+    pthread_cond_broadcast(&writer->cond);
+  }
+  pthread_mutex_unlock(&writer->mutex);
+  return NULL;
+}
+
+/**
+ * @brief Inicia el hilo que escribe los puntos de control.
+ *
+ * @param writer Estructura del hilo escritor.
+ * @param path Ruta del archivo de punto de control.
+ * @return EXIT_SUCCESS si el hilo se creó, o EXIT_FAILURE si ocurre un error.
+ */
+int checkpoint_start(CheckpointWriter* writer, const char* path) {
+  memset(writer, 0, sizeof(CheckpointWriter));
+  snprintf(writer->path, sizeof(writer->path), "%s", path);
+  writer->current.magic = CHECKPOINT_MAGIC;
+  pthread_mutex_init(&writer->mutex, NULL);
+  pthread_cond_init(&writer->cond, NULL);
+  if (pthread_create(&writer->thread, NULL, run_writer, writer) != 0) {
+    fprintf(stderr, "Error creating the checkpoint thread\n");
+    pthread_mutex_destroy(&writer->mutex);
+    pthread_cond_destroy(&writer->cond);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Entrega el estado actual de la simulación al hilo escritor.
+ *
+ * @details Copia la lámina a la memoria del hilo escritor y retorna. Si el
+ * hilo sigue ocupado con el punto anterior no se copia nada, para no detener
+ * la simulación.
+ *
+ * @param writer Estructura del hilo escritor.
+ * @param matrix Lámina en el estado k.
+ * @param k Estados ya calculados.
+ * @param time_seconds Tiempo simulado hasta el estado k.
+ * @return true si el punto de control se aceptó.
+ */
+bool checkpoint_offer(CheckpointWriter* writer, const Matrix* matrix, int k,
+  time_t time_seconds) {
+  pthread_mutex_lock(&writer->mutex);
+  if (writer->pending || writer->busy) {
+    pthread_mutex_unlock(&writer->mutex);
+    return false;
+  }
+  /** Reservar la copia solo cuando cambian las dimensiones. */
+  if (writer->snapshot.rows != matrix->rows ||
+    writer->snapshot.cols != matrix->cols || !writer->snapshot.buffer) {
+    matrix_destroy(&writer->snapshot);
+    if (matrix_create(&writer->snapshot, matrix->rows, matrix->cols) !=
+      EXIT_SUCCESS) {
+      pthread_mutex_unlock(&writer->mutex);
+      return false;
+    }
+  }
+  memcpy(writer->snapshot.buffer, matrix->buffer,
+    matrix->rows * matrix->stride * sizeof(double));
+  writer->header = writer->current;
+  writer->header.k = k;
+  writer->header.time_seconds = time_seconds;
+  writer->rows = matrix->rows;
+  writer->cols = matrix->cols;
+  writer->pending = true;
+  pthread_cond_signal(&writer->cond);
+  pthread_mutex_unlock(&writer->mutex);
+  return true;
+}
+
+/**
+ * @brief Registra que la línea en curso del trabajo terminó.
+ *
+ * @details Se llama después de escribir el reporte y la lámina de la línea.
+ * Espera a que el hilo escritor termine el punto anterior y le entrega un
+ * punto de control sin lámina que indica que la siguiente línea empieza
+ * desde cero.
+ *
+ * @param writer Estructura del hilo escritor.
+ */
+void checkpoint_finish_line(CheckpointWriter* writer) {
+  writer->current.line++;
+  pthread_mutex_lock(&writer->mutex);
+  while (writer->pending || writer->busy) {
+    pthread_cond_wait(&writer->cond, &writer->mutex);
+  }
+  writer->header = writer->current;
+  writer->header.k = 0;
+  writer->header.time_seconds = 0;
+  writer->rows = 0;
+  writer->cols = 0;
+  writer->pending = true;
+  pthread_cond_signal(&writer->cond);
+  pthread_mutex_unlock(&writer->mutex);
+}
+
+/**
+ * @brief Detiene el hilo escritor y libera su memoria.
+ *
+ * @details Los puntos de control pendientes se escriben antes de terminar.
+ *
+ * @param writer Estructura del hilo escritor.
+ */
+void checkpoint_stop(CheckpointWriter* writer) {
+  pthread_mutex_lock(&writer->mutex);
+  writer->finished = true;
+  pthread_cond_signal(&writer->cond);
+  pthread_mutex_unlock(&writer->mutex);
+  pthread_join(writer->thread, NULL);
+  pthread_mutex_destroy(&writer->mutex);
+  pthread_cond_destroy(&writer->cond);
+  matrix_destroy(&writer->snapshot);
+}
+
+/**
+ * @brief Lee un archivo de punto de control.
+ *
+ * @param path Ruta del archivo de punto de control.
+ * @param header Encabezado leído.
+ * @param matrix Recibe la lámina si el punto de control tiene una; si no, se
+ * deja sin reservar.
+ * @return EXIT_SUCCESS si la operación es exitosa, o EXIT_FAILURE si el
+ * archivo no existe o no es válido.
+ */
+int checkpoint_read(const char* path, CheckpointHeader* header,
+  Matrix* matrix) {
+  memset(matrix, 0, sizeof(Matrix));
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    return EXIT_FAILURE;
+  }
+  uint64_t rows = 0, cols = 0;
+  if (fread(header, sizeof(CheckpointHeader), 1, file) != 1 ||
+    header->magic != CHECKPOINT_MAGIC ||
+    fread(&rows, sizeof(uint64_t), 1, file) != 1 ||
+    fread(&cols, sizeof(uint64_t), 1, file) != 1) {
+    fprintf(stderr, "Error: invalid checkpoint file %s\n", path);
+    fclose(file);
+    return EXIT_FAILURE;
+  }
+  if (rows > 0) {
+    if (matrix_create(matrix, rows, cols) != EXIT_SUCCESS) {
+      perror("Error allocating checkpoint data");
+      fclose(file);
+      return EXIT_FAILURE;
+    }
+    for (uint64_t i = 0; i < rows; i++) {
+      if (fread(matrix_row(matrix, i), sizeof(double), cols, file) != cols) {
+        fprintf(stderr, "Error: truncated checkpoint file %s\n", path);
+        matrix_destroy(matrix);
+        fclose(file);
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  fclose(file);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,79 @@
+// Copyright 2024 Josué Torres Sibaja <josue.torressibaja@ucr.ac.cr>
+
+#ifndef TAREAS_SERIAL_SRC_CHECKPOINT_H_
+#define TAREAS_SERIAL_SRC_CHECKPOINT_H_
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "matrix.h"
+
+/** Identifica los archivos de punto de control ("HEATCKP1"). */
+#define CHECKPOINT_MAGIC 0x31504B4354414548ULL
+
+/**
+ * Segundos entre puntos de control durante una simulación. Se puede cambiar
+ * al compilar, por ejemplo DEFS=-DCHECKPOINT_INTERVAL=1.
+ */
+#ifndef CHECKPOINT_INTERVAL
+#define CHECKPOINT_INTERVAL 60
+#endif
+
+/**
+ * Celdas que se calculan entre dos consultas del reloj. Evita consultar el
+ * reloj en cada estado cuando la lámina es pequeña.
+ */
+#define CHECKPOINT_CLOCK_CELLS (1 << 24)
+
+/**
+ * @brief Encabezado de un archivo de punto de control.
+ *
+ * @details Después del encabezado el archivo sigue el mismo formato de las
+ * láminas: filas y columnas como enteros de 8 bytes y luego las temperaturas
+ * fila por fila. Una lámina de 0 x 0 indica que la línea 'line' del trabajo
+ * todavía no ha empezado y que las anteriores ya terminaron.
+ */
+typedef struct checkpoint_header {
+  uint64_t magic;  /** Siempre CHECKPOINT_MAGIC. */
+  uint64_t line;  /** Línea del archivo de trabajo en curso, desde 0. */
+  int64_t k;  /** Estados ya calculados. */
+  int64_t time_seconds;  /** Tiempo simulado hasta el estado k. */
+  double delta_t, alpha, h, epsilon;  /** Parámetros de la línea. */
+} CheckpointHeader;
+
+/**
+ * @brief Hilo que escribe los puntos de control en segundo plano.
+ *
+ * @details La simulación entrega una copia de la lámina y sigue calculando
+ * mientras el hilo la escribe. Si el hilo todavía está escribiendo el punto
+ * anterior, el nuevo se descarta, de modo que los estados nunca esperan por
+ * el disco.
+ */
+typedef struct checkpoint_writer {
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  bool pending;  /** Hay un punto de control listo para escribir. */
+  bool busy;  /** El hilo está escribiendo un punto de control. */
+  bool finished;  /** El hilo debe terminar. */
+  char path[1024];  /** Ruta del archivo de punto de control. */
+  CheckpointHeader header;  /** Encabezado del punto que se escribe. */
+  CheckpointHeader current;  /** Línea en curso, del hilo principal. */
+  Matrix snapshot;  /** Copia de la lámina que se escribe. */
+  uint64_t rows, cols;  /** Dimensiones que se escriben; 0 sin lámina. */
+} CheckpointWriter;
+
+int checkpoint_path(char* path, size_t capacity, const char* job_file,
+  const char* output_dir);
+int checkpoint_start(CheckpointWriter* writer, const char* path);
+bool checkpoint_offer(CheckpointWriter* writer, const Matrix* matrix, int k,
+  time_t time_seconds);
+void checkpoint_finish_line(CheckpointWriter* writer);
+void checkpoint_stop(CheckpointWriter* writer);
+int checkpoint_read(const char* path, CheckpointHeader* header,
+  Matrix* matrix);
+
+#endif  // TAREAS_SERIAL_SRC_CHECKPOINT_H_
@@ -18,7 +18,9 @@
  * 
  * @details Lee el archivo de trabajo especificado, realiza la simulación de 
  * propagación de calor para cada lámina, y genera archivos de reporte y de 
- * salida con los resultados.
+ * salida con los resultados. Durante la simulación se guardan puntos de
+ * control en el directorio de salida; con la opción --resume el trabajo
+ * continúa desde el último punto de control en lugar de empezar de nuevo.
  * 
  * @param argc Número de argumentos de la línea de comandos.
  * @param argv Arreglo de argumentos de la línea de comandos.
@@ -29,14 +31,30 @@ int main(int argc, char *argv[]) {
   struct timespec start_time, finish_time;
   clock_gettime(/*clk_id*/CLOCK_MONOTONIC, &start_time);
 
+  /** Elegir el kernel de la simulación según el procesador. */
+  stencil_init();
+
+  /** Retirar la opción --resume de los argumentos, en cualquier posición. */
+  bool resume = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--resume") == 0) {
+      resume = true;
+      for (int j = i; j < argc - 1; j++) {
+        argv[j] = argv[j + 1];
+      }
+      argc--;
+      i--;
+    }
+  }
+
   /**
    * @brief Verifica que los argumentos proporcionados en la línea de comandos 
    * sean correctos.
    */
   if (argc < 3 || argc > 5) {
     fprintf(stderr,
-      "Usage: %s <job file> <thread count> <input dir> <output dir>\n",
-        argv[0]);
+      "Usage: %s <job file> <thread count> <input dir> <output dir> "
+        "[--resume]\n", argv[0]);
     return EXIT_FAILURE;
   }
 
@@ -68,31 +86,94 @@ int main(int argc, char *argv[]) {
     return EXIT_FAILURE;
   }
 
+  /**
+   * @brief Prepara los puntos de control. Al reanudar, las líneas anteriores a
+   * la del punto de control ya terminaron y la línea del punto de control
+   * continúa desde el estado guardado, si lo tiene.
+   */
+  char checkpoint_file[MAX_PATH_LENGTH];
+  if (checkpoint_path(checkpoint_file, sizeof(checkpoint_file), job_file,
+    output_dir) != EXIT_SUCCESS) {
+    fclose(file);
+    return EXIT_FAILURE;
+  }
+  CheckpointHeader resume_header = {0};
+  Matrix resume_matrix = {0};
+  if (resume && checkpoint_read(checkpoint_file, &resume_header,
+    &resume_matrix) != EXIT_SUCCESS) {
+    /** Sin un punto de control válido el trabajo empieza desde el inicio. */
+    resume = false;
+  }
+  CheckpointWriter checkpoint_writer;
+  CheckpointWriter* writer = &checkpoint_writer;
+  if (checkpoint_start(writer, checkpoint_file) != EXIT_SUCCESS) {
+    writer = NULL;
+  }
+
   char input_filepath[MAX_PATH_LENGTH];
   char plate_filename[MAX_PATH_LENGTH];
   double delta_t, alpha, h, epsilon;
+  uint64_t line = 0;
+  int error = EXIT_SUCCESS;
 
   /** Bucle de lectura de configuración del archivo de trabajo. */
   while (fscanf(file, "%s %lf %lf %lf %lf", plate_filename, &delta_t, &alpha,
     &h, &epsilon) == 5) {
+    /** Saltar las líneas que terminaron antes del punto de control. */
+    if (resume && line < resume_header.line) {
+      line++;
+      continue;
+    }
+
     /** Verificar el tamaño de la ruta. */
     int written = snprintf(input_filepath, sizeof(input_filepath), "%s/%s",
       input_dir, plate_filename);
     if (written < 0 || written >= (int) sizeof(input_filepath)) {  // NOLINT
       fprintf(stderr, "Error: the file path is too long\n");
-      fclose(file);
-      return EXIT_FAILURE;
+      error = EXIT_FAILURE;
+      break;
     }
 
     /** Leer las dimensiones y datos de la placa. */
     Plate plate;
     if (read_dimensions(input_filepath, &plate) != EXIT_SUCCESS) {
-      fclose(file);
-      return EXIT_FAILURE;
+      error = EXIT_FAILURE;
+      break;
     }
-    if (read_plate(input_filepath, &plate) != EXIT_SUCCESS) {
-      fclose(file);
-      return EXIT_FAILURE;
+
+    /**
+     * Continuar desde el punto de control si pertenece a esta línea y a esta
+     * lámina; si no, leer la lámina inicial.
+     */
+    int k = 0;
+    time_t time_seconds = 0;
+    bool resumed = false;
+    if (resume && line == resume_header.line && resume_matrix.buffer) {
+      if (resume_header.delta_t == delta_t && resume_header.alpha == alpha &&
+        resume_header.h == h && resume_header.epsilon == epsilon &&
+        (long long int) resume_matrix.rows == plate.rows &&  // NOLINT
+        (long long int) resume_matrix.cols == plate.cols) {  // NOLINT
+        plate.matrix = resume_matrix;
+        k = (int) resume_header.k;
+        time_seconds = (time_t) resume_header.time_seconds;
+        resumed = true;
+      } else {
+        fprintf(stderr, "Warning: the checkpoint does not match line %" PRIu64
+          ", starting it again\n", line);
+        matrix_destroy(&resume_matrix);
+      }
+      resume_matrix.buffer = NULL;
+    }
+    if (!resumed && read_plate(input_filepath, &plate) != EXIT_SUCCESS) {
+      error = EXIT_FAILURE;
+      break;
+    }
+    if (writer) {
+      writer->current.line = line;
+      writer->current.delta_t = delta_t;
+      writer->current.alpha = alpha;
+      writer->current.h = h;
+      writer->current.epsilon = epsilon;
     }
 
     /**
@@ -107,9 +188,7 @@ int main(int argc, char *argv[]) {
      * - Genera un archivo de reporte con los resultados de la simulación.
      * - Guarda el estado final de la matriz en un archivo binario.
      */
-    int k;
-    time_t time_seconds;
-    simulate(&plate, delta_t, alpha, h, epsilon, &k, &time_seconds);
+    simulate(&plate, delta_t, alpha, h, epsilon, &k, &time_seconds, writer);
 
     /** Genera el reporte de la simulación. */
     create_report(job_file, plate_filename, delta_t, alpha, h, epsilon, k,
@@ -121,12 +200,28 @@ int main(int argc, char *argv[]) {
     write_plate(output_filename, &plate);
 
     /** Libera la memoria dinámica que se ha utilizado durante la ejecución. */
-    for (long long int i = 0; i < plate.rows; i++) {
-      free(plate.data[i]);
+    matrix_destroy(&plate.matrix);
+
+    /** La línea terminó: un nuevo punto de control la marca como hecha. */
+    if (writer) {
+      checkpoint_finish_line(writer);
     }
-    free(plate.data);
+    line++;
   }
   fclose(file);
+  matrix_destroy(&resume_matrix);
+
+  /**
+   * Esperar a que se escriba el último punto de control. Si el trabajo
+   * terminó, el punto de control ya no hace falta.
+   */
+  if (writer) {
+    checkpoint_stop(writer);
+  }
+  if (error != EXIT_SUCCESS) {
+    return error;
+  }
+  remove(checkpoint_file);
 
   /** Tomar el tiempo de finalización. */
   clock_gettime(/*clk_id*/CLOCK_MONOTONIC, &finish_time);
@@ -56,23 +56,23 @@ int read_plate(const char* filepath, Plate* plate) {
   /** Saltar los primeros 16 bytes que contienen las dimensiones. */
   fseek(file, 2 * sizeof(long long int), SEEK_SET);
 
-  /**
-   * @brief Asigna memoria para un arreglo de punteros, donde cada uno es una 
-   * fila de la placa térmica.
-   */
-  plate->data = (double**) malloc(plate->rows * sizeof(double *));  // NOLINT
+  /** Asigna un único bloque contiguo y alineado para toda la placa. */
+  if (matrix_create(&plate->matrix, plate->rows, plate->cols) !=
+    EXIT_SUCCESS) {
+    perror("Error allocating plate data");
+    fclose(file);
+    return EXIT_FAILURE;
+  }
 
-  /** Se asigna memoria para cada fila de la matriz. */
   for (long long int i = 0; i < plate->rows; i++) {
-    plate->data[i] = (double*) malloc(plate->cols * sizeof(double));  // NOLINT
-
     /**
      * @brief Leer los datos de la placa térmica desde el archivo binario y 
      * almacenarlos en la matriz.
      */
-    if (fread(plate->data[i], sizeof(double), (size_t) plate->cols, file) !=
-      (size_t) plate->cols) {
+    if (fread(matrix_row(&plate->matrix, i), sizeof(double),
+      (size_t) plate->cols, file) != (size_t) plate->cols) {
       perror("Error reading plate data");
+      matrix_destroy(&plate->matrix);
       fclose(file);
       return EXIT_FAILURE;
     }
@@ -89,57 +89,79 @@ int read_plate(const char* filepath, Plate* plate) {
  * placa representada por la estructura Plate. La simulación se ejecuta 
  * iterativamente hasta que la diferencia máxima entre los valores de 
  * temperatura de la placa sea menor que un valor epsilon, lo que indica que 
- * se ha alcanzado el equilibrio térmico.
+ * se ha alcanzado el equilibrio térmico. La simulación continúa desde los
+ * valores de 'k' y 'time_seconds' recibidos, lo que permite reanudarla desde
+ * un punto de control. Cada CHECKPOINT_INTERVAL segundos el estado se entrega
+ * al hilo escritor, que lo guarda en segundo plano.
  * 
  * @param plate Puntero a la estructura que contiene la matriz de datos.
  * @param delta_t Tiempo permitido entre un estado y otro.
  * @param alpha Coeficiente de difusión térmica.
  * @param h Alto y ancho de cada celda.
  * @param epsilon Mínimo cambio de temperatura significativo.
- * @param k Puntero donde se almacenará la cantidad de estados.
- * @param time_seconds Puntero donde se almacenará el tiempo total en segundos.
+ * @param k Estados ya calculados; al terminar, la cantidad de estados.
+ * @param time_seconds Tiempo ya simulado; al terminar, el tiempo total en
+ * segundos.
+ * @param writer Hilo escritor de puntos de control, o NULL para no guardarlos.
  */
 void simulate(Plate* plate, double delta_t, double alpha, double h,
-  double epsilon, int* k, time_t* time_seconds) {
+  double epsilon, int* k, time_t* time_seconds, CheckpointWriter* writer) {
   /** Inicialización de estructuras de datos. */
   double max_delta;
-  double** next_plate = (double**) malloc(plate->rows * sizeof(double *));  // NOLINT
-  for (long long int i = 0; i < plate->rows; i++) {
-    next_plate[i] = (double*) malloc(plate->cols * sizeof(double));  // NOLINT
+  Matrix next_plate;
+  if (matrix_create(&next_plate, plate->rows, plate->cols) != EXIT_SUCCESS) {
+    perror("Error allocating next plate");
+    return;
   }
+  /** Copiar los bordes una sola vez; no cambian durante la simulación. */
+  memcpy(next_plate.buffer, plate->matrix.buffer,
+    plate->rows * plate->matrix.stride * sizeof(double));
 
-  *k = 0; /** Declaración de contadores. */
-  *time_seconds = 0;
+  /** Constante de la fórmula, igual para todas las celdas. */
+  const double factor = (delta_t * alpha) / (h * h);
+  /** Momento del último punto de control y celdas calculadas desde entonces. */
+  struct timespec last_checkpoint;
+  clock_gettime(/*clk_id*/CLOCK_MONOTONIC, &last_checkpoint);
+  uint64_t clock_cells = 0;
 
   /** Algoritmo de simulación de calor. */
   do {
     max_delta = 0.0;
     for (long long int i = 1; i < plate->rows - 1; i++) {
-      for (long long int j = 1; j < plate->cols - 1; j++) {
-        /** Aplica la fórmula para calcular la nueva temperatura. */
-        next_plate[i][j] = plate->data[i][j] + (((delta_t * alpha) / (h * h)) *
-          (plate->data[i-1][j] + plate->data[i+1][j] + plate->data[i][j-1] +
-            plate->data[i][j+1] - (4 * plate->data[i][j])));
-
-        double delta = fabs(next_plate[i][j] - plate->data[i][j]);
-        if (delta > max_delta) {
-          max_delta = delta;
-        }
-      }
-    }
-    /** Copiar nuevas temperaturas a la matriz principal. */
-    for (long long int i = 1; i < plate->rows - 1; i++) {
-      for (long long int j = 1; j < plate->cols - 1; j++) {
-        plate->data[i][j] = next_plate[i][j];
+      const double* up = matrix_row(&plate->matrix, i - 1);
+      const double* row = matrix_row(&plate->matrix, i);
+      const double* down = matrix_row(&plate->matrix, i + 1);
+      double* next = matrix_row(&next_plate, i);
+      /** Aplica la fórmula a la fila con el kernel vectorial disponible. */
+      double delta = stencil_row(up, row, down, next, plate->cols, factor);
+      if (delta > max_delta) {
+        max_delta = delta;
       }
     }
+    /** Intercambiar matrices: las nuevas temperaturas pasan a la lámina. */
+    Matrix temp = plate->matrix;
+    plate->matrix = next_plate;
+    next_plate = temp;
     (*k)++; /** Incrementar contadores. */
     *time_seconds += delta_t;
+
+    /**
+     * Guardar un punto de control si pasó el intervalo. Solo se guardan
+     * estados desde los que la simulación continúa.
+     */
+    clock_cells += (uint64_t) (plate->rows * plate->cols);
+    if (writer && max_delta > epsilon &&
+      clock_cells >= CHECKPOINT_CLOCK_CELLS) {
+      clock_cells = 0;
+      struct timespec now;
+      clock_gettime(/*clk_id*/CLOCK_MONOTONIC, &now);
+      if (now.tv_sec - last_checkpoint.tv_sec >= CHECKPOINT_INTERVAL &&
+        checkpoint_offer(writer, &plate->matrix, *k, *time_seconds)) {
+        last_checkpoint = now;
+      }
+    }
   } while (max_delta > epsilon); /** Condición de parada. */
-  for (long long int i = 0; i < plate->rows; i++) { /** Liberar memoria. */
-    free(next_plate[i]);
-  }
-  free(next_plate);
+  matrix_destroy(&next_plate); /** Liberar memoria. */
 }
 
 /**
@@ -166,7 +188,7 @@ int write_plate(const char* filepath, Plate* plate) {
 
   /** Escribe cada fila de la matriz de temperaturas en el archivo binario. */
   for (long long int i = 0; i < plate->rows; i++) {
-    fwrite(plate->data[i], sizeof(double), plate->cols, file);
+    fwrite(matrix_row(&plate->matrix, i), sizeof(double), plate->cols, file);
   }
   fclose(file);
   return EXIT_SUCCESS;
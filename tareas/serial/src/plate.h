@@ -6,9 +6,10 @@
 /** Especificar el tamaño máximo permitido para las rutas de archivos. */
 #define MAX_PATH_LENGTH 1024
 
-/** Medir tiempo de ejecución. */
-#define _POSIX_C_SOURCE 199309L
+/** Medir tiempo de ejecución y sincronizar archivos con el disco. */
+#define _POSIX_C_SOURCE 200809L
 
+#include <inttypes.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -18,6 +19,10 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "checkpoint.h"
+#include "matrix.h"
+#include "stencil.h"
+
 /**
  * @struct Plate
  * @brief Estructura para representar una placa térmica en la simulación.
@@ -28,14 +33,14 @@
 typedef struct {
   long long int rows; /** Número de filas. */
   long long int cols; /** Número de columnas. */
-  double** data; /** Puntero a la matriz de datos. */
+  Matrix matrix; /** Matriz contigua con los datos. */
 } Plate;
 
 /** Declaración de funciones relacionadas con Plate. */
 int read_dimensions(const char* filepath, Plate* plate);
 int read_plate(const char* filepath, Plate* plate);
 void simulate(Plate* plate, double delta_t, double alpha, double h,
-  double epsilon, int* k, time_t* time_seconds);
+  double epsilon, int* k, time_t* time_seconds, CheckpointWriter* writer);
 int write_plate(const char* filepath, Plate* plate);
 
 /** Declaración de funciones auxiliares en utils.c. */